@@ -0,0 +1,145 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "../ChunkList/ChunkList.hpp"
+
+using namespace fefu_laboratory_two;
+
+//Sequential scan rate over cold, scattered chunks with and without chunk prefetching
+
+namespace {
+    constexpr std::size_t total_bytes = 32u << 20;
+    constexpr int repeats = 5;
+    const int distances[] = {0, 1, 2, 4};
+
+    //Leaves a random gap after every chunk buffer, so that neighbouring chunks are not adjacent in memory
+    //and the hardware stream prefetcher cannot guess the next one
+    template<typename T>
+    class ScatteringAllocator {
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+
+        static std::vector<void *> &gaps() {
+            static std::vector<void *> blocks;
+            return blocks;
+        }
+
+        static std::mt19937 &random() {
+            static std::mt19937 generator(42);
+            return generator;
+        }
+
+        T *allocate(size_type n) {
+            gaps().push_back(malloc(64 + random()() % 1024));
+            T *ptr = static_cast<T *>(malloc(sizeof(T) * n));
+            return ptr ? ptr : throw std::bad_alloc();
+        }
+
+        void deallocate(T *p, size_type) noexcept {
+            free(p);
+        }
+
+        static void release_gaps() {
+            for (void *gap : gaps())
+                free(gap);
+            gaps().clear();
+        }
+
+        friend bool operator==(const ScatteringAllocator &, const ScatteringAllocator &) noexcept {
+            return true;
+        }
+
+        friend bool operator!=(const ScatteringAllocator &, const ScatteringAllocator &) noexcept {
+            return false;
+        }
+    };
+
+    void evict_line(const void *address) {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_clflush(address);
+#else
+        (void) address;
+#endif
+    }
+
+    //Gives access to the chain so that every header and buffer can be flushed from the caches. Last level
+    //caches can be hundreds of megabytes, so streaming through a scratch buffer does not make them cold
+    template<int N>
+    class ScanList : public ChunkList<std::int64_t, N, ScatteringAllocator<std::int64_t>> {
+    public:
+        explicit ScanList(std::size_t count) : ChunkList<std::int64_t, N, ScatteringAllocator<std::int64_t>>(count, 0) {}
+
+        void evict() const {
+            for (const Chunk<std::int64_t> *current_chunk = this->chunks; current_chunk != nullptr;
+                 current_chunk = current_chunk->next) {
+                evict_line(current_chunk);
+                evict_line(reinterpret_cast<const char *>(current_chunk) + sizeof(*current_chunk) - 1);
+                const char *data = reinterpret_cast<const char *>(current_chunk->chunk);
+                for (std::size_t offset = 0; offset < N * sizeof(std::int64_t); offset += 64)
+                    evict_line(data + offset);
+            }
+#if defined(__x86_64__) || defined(__i386__)
+            _mm_mfence();
+#endif
+        }
+    };
+
+    template<int N>
+    void bench() {
+        std::size_t count = total_bytes / sizeof(std::int64_t);
+        ScanList<N> list(count);
+        std::int64_t next_value = 0;
+        for (std::int64_t &value : list)
+            value = next_value++;
+
+        std::printf("N=%-4d", N);
+        for (int distance : distances) {
+            set_chunk_prefetch_distance(distance);
+            double best = 1e30;
+            std::int64_t sum = 0;
+            for (int repeat = 0; repeat < repeats; repeat++) {
+                list.evict();
+                auto start = std::chrono::steady_clock::now();
+                std::int64_t local_sum = 0;
+                for (std::int64_t value : list)
+                    local_sum += value;
+                auto stop = std::chrono::steady_clock::now();
+                sum += local_sum;
+                double seconds = std::chrono::duration<double>(stop - start).count();
+                if (seconds < best)
+                    best = seconds;
+            }
+            if (sum != repeats * static_cast<std::int64_t>(count) * (static_cast<std::int64_t>(count) - 1) / 2)
+                std::printf(" checksum mismatch");
+            std::printf("  %10.1f", count / best / 1e6);
+        }
+        std::printf("\n");
+        ScatteringAllocator<std::int64_t>::release_gaps();
+    }
+}
+
+int main() {
+    std::printf("Scan rate in million elements per second, int64 payload, cold cache\n");
+    std::printf("%-6s", "");
+    for (int distance : distances)
+        std::printf("  %10s", distance == 0 ? "off" : (std::string("dist ") + std::to_string(distance)).c_str());
+    std::printf("\n");
+    bench<8>();
+    bench<16>();
+    bench<32>();
+    bench<64>();
+    bench<128>();
+    bench<256>();
+    set_chunk_prefetch_distance(CHUNKLIST_PREFETCH_DISTANCE);
+    return 0;
+}
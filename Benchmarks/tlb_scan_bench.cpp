@@ -0,0 +1,155 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "../ChunkList/ChunkList.hpp"
+#include "../ChunkList/HugePageAllocator.hpp"
+
+using namespace fefu_laboratory_two;
+
+//Scans of 512 KB chunks from malloc and from HugePageAllocator, with data TLB misses read from the
+//perf counters when the kernel lets us
+
+namespace {
+    constexpr int chunk_elements = 65536;
+    constexpr std::size_t total_elements = std::size_t(32) << 20; //256 MB of int64
+    constexpr int page_stride = 4096 / sizeof(std::int64_t);
+    constexpr int repeats = 3;
+
+    //Data TLB read misses of this thread, or nothing when perf events are not available
+    class TlbMissCounter {
+        int descriptor = -1;
+
+    public:
+        TlbMissCounter() {
+#if defined(__linux__)
+            perf_event_attr attributes;
+            std::memset(&attributes, 0, sizeof(attributes));
+            attributes.size = sizeof(attributes);
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            descriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+        }
+
+        ~TlbMissCounter() {
+#if defined(__linux__)
+            if (descriptor >= 0)
+                close(descriptor);
+#endif
+        }
+
+        bool available() const noexcept {
+            return descriptor >= 0;
+        }
+
+        void start() {
+#if defined(__linux__)
+            if (descriptor >= 0) {
+                ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+                ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        long long stop() {
+            long long misses = 0;
+#if defined(__linux__)
+            if (descriptor >= 0) {
+                ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+                if (read(descriptor, &misses, sizeof(misses)) != sizeof(misses))
+                    misses = 0;
+            }
+#endif
+            return misses;
+        }
+    };
+
+    //Exposes the chain for the page-stride pass, which reads one element per 4K page
+    template<typename Alloc>
+    class ScanList : public ChunkList<std::int64_t, chunk_elements, Alloc> {
+    public:
+        explicit ScanList(const Alloc &alloc) : ChunkList<std::int64_t, chunk_elements, Alloc>(total_elements, 1, alloc) {}
+
+        std::int64_t page_stride_sum() const {
+            std::int64_t sum = 0;
+            for (const Chunk<std::int64_t> *current_chunk = this->chunks; current_chunk != nullptr;
+                 current_chunk = current_chunk->next) {
+                for (int i = 0; i < current_chunk->current_chunk_size; i += page_stride)
+                    sum += current_chunk->chunk[i];
+            }
+            return sum;
+        }
+    };
+
+    void report(const char *pass, double seconds, long long misses, bool have_counter) {
+        std::printf("  %-12s %9.2f ms", pass, seconds * 1e3);
+        if (have_counter)
+            std::printf("  %12lld dTLB misses\n", misses);
+        else
+            std::printf("  %12s dTLB misses\n", "n/a");
+    }
+
+    template<typename Alloc>
+    void bench(const char *name, const Alloc &alloc) {
+        ScanList<Alloc> list(alloc);
+        TlbMissCounter counter;
+        std::printf("%s\n", name);
+
+        double best = 1e30;
+        long long best_misses = 0;
+        std::int64_t sum = 0;
+        for (int repeat = 0; repeat < repeats; repeat++) {
+            counter.start();
+            auto start = std::chrono::steady_clock::now();
+            for (std::int64_t value : list)
+                sum += value;
+            auto stop = std::chrono::steady_clock::now();
+            long long misses = counter.stop();
+            double seconds = std::chrono::duration<double>(stop - start).count();
+            if (seconds < best) {
+                best = seconds;
+                best_misses = misses;
+            }
+        }
+        report("full scan", best, best_misses, counter.available());
+
+        best = 1e30;
+        for (int repeat = 0; repeat < repeats; repeat++) {
+            counter.start();
+            auto start = std::chrono::steady_clock::now();
+            sum += list.page_stride_sum();
+            auto stop = std::chrono::steady_clock::now();
+            long long misses = counter.stop();
+            double seconds = std::chrono::duration<double>(stop - start).count();
+            if (seconds < best) {
+                best = seconds;
+                best_misses = misses;
+            }
+        }
+        report("page stride", best, best_misses, counter.available());
+        if (sum == 0)
+            std::printf("checksum mismatch\n");
+    }
+}
+
+int main() {
+    bench("malloc", Allocator<std::int64_t>());
+    HugePageAllocator<std::int64_t> huge_pages;
+    bench("HugePageAllocator", huge_pages);
+    std::printf("HugePageAllocator: %zu regions, %zu advised for huge pages\n", huge_pages.stats().regions,
+                huge_pages.stats().huge_page_regions);
+    return 0;
+}
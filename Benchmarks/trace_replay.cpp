@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../ChunkList/ChunkList.hpp"
+#include "../ChunkList/ChunkListTrace.hpp"
+#include "../ChunkList/HugePageAllocator.hpp"
+
+using namespace fefu_laboratory_two;
+
+//Replays a trace recorded with ChunkListTraceRecorder against ChunkList with several chunk sizes and
+//allocators and against std::deque, and prints latency percentiles of every operation.
+//
+//  trace_replay <trace>          replay a recorded trace
+//  trace_replay --demo <trace>   write a synthetic queue-like trace to <trace>, then replay it
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::size_t operation_count = static_cast<std::size_t>(TraceOperation::count);
+    const char *const operation_names[operation_count] = {"push_back", "pop_back", "insert", "erase", "access",
+                                                          "clear"};
+
+    //Stands in for the recorded element type, which the replay cannot know
+    template<std::size_t Bytes>
+    struct Payload {
+        std::array<unsigned char, Bytes> bytes{};
+    };
+
+    volatile unsigned char sink;
+
+    std::int64_t nanoseconds(Clock::time_point start, Clock::time_point stop) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+    }
+
+    //Median cost of reading the clock twice, which every latency below includes
+    std::int64_t timer_floor() {
+        std::vector<std::int64_t> samples(10001);
+        for (std::int64_t &sample : samples) {
+            auto start = Clock::now();
+            sample = nanoseconds(start, Clock::now());
+        }
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    //ChunkList iterators only step one element at a time
+    template<typename List>
+    typename List::iterator iterator_at(List &list, std::size_t position) {
+        auto current = list.begin();
+        for (std::size_t i = 0; i < position; i++)
+            ++current;
+        return current;
+    }
+
+    template<typename Element>
+    typename std::deque<Element>::iterator iterator_at(std::deque<Element> &list, std::size_t position) {
+        return list.begin() + static_cast<std::ptrdiff_t>(position);
+    }
+
+    std::int64_t percentile(const std::vector<std::int64_t> &sorted, double share) {
+        std::size_t index = static_cast<std::size_t>(share * (sorted.size() - 1) + 0.5);
+        return sorted[index];
+    }
+
+    //Runs every record against list. Iterators for insert and erase are found outside the timed region,
+    //since the traced program already held them
+    template<typename List>
+    void replay(const char *name, const std::vector<TraceRecord> &records, List &list) {
+        using Element = typename List::value_type;
+        std::array<std::vector<std::int64_t>, operation_count> latencies;
+        Element value;
+        auto replay_start = Clock::now();
+        for (std::size_t index = 0; index < records.size(); index++) {
+            const TraceRecord &record = records[index];
+            if (list.size() != record.size) {
+                std::printf("%s: out of step at record %zu, size %zu instead of %zu\n", name, index, list.size(),
+                            record.size);
+                return;
+            }
+            std::int64_t latency = 0;
+            switch (record.operation) {
+                case TraceOperation::push_back: {
+                    auto start = Clock::now();
+                    list.push_back(value);
+                    latency = nanoseconds(start, Clock::now());
+                    break;
+                }
+                case TraceOperation::pop_back: {
+                    auto start = Clock::now();
+                    list.pop_back();
+                    latency = nanoseconds(start, Clock::now());
+                    break;
+                }
+                case TraceOperation::insert: {
+                    auto position = iterator_at(list, record.position);
+                    auto start = Clock::now();
+                    list.insert(position, value);
+                    latency = nanoseconds(start, Clock::now());
+                    break;
+                }
+                case TraceOperation::erase: {
+                    auto position = iterator_at(list, record.position);
+                    auto start = Clock::now();
+                    list.erase(position);
+                    latency = nanoseconds(start, Clock::now());
+                    break;
+                }
+                case TraceOperation::access: {
+                    auto start = Clock::now();
+                    sink = list[record.position].bytes[0];
+                    latency = nanoseconds(start, Clock::now());
+                    break;
+                }
+                case TraceOperation::clear: {
+                    auto start = Clock::now();
+                    list.clear();
+                    latency = nanoseconds(start, Clock::now());
+                    break;
+                }
+                default:
+                    break;
+            }
+            latencies[static_cast<std::size_t>(record.operation)].push_back(latency);
+        }
+        double total = std::chrono::duration<double>(Clock::now() - replay_start).count();
+
+        std::printf("%s (%.1f ms including iterator walks)\n", name, total * 1e3);
+        std::printf("  %-10s %10s %8s %8s %8s %8s %10s\n", "operation", "count", "p50", "p90", "p99", "p99.9",
+                    "max ns");
+        for (std::size_t operation = 0; operation < operation_count; operation++) {
+            std::vector<std::int64_t> &samples = latencies[operation];
+            if (samples.empty())
+                continue;
+            std::sort(samples.begin(), samples.end());
+            std::printf("  %-10s %10zu %8lld %8lld %8lld %8lld %10lld\n", operation_names[operation], samples.size(),
+                        static_cast<long long>(percentile(samples, 0.5)),
+                        static_cast<long long>(percentile(samples, 0.9)),
+                        static_cast<long long>(percentile(samples, 0.99)),
+                        static_cast<long long>(percentile(samples, 0.999)), static_cast<long long>(samples.back()));
+        }
+    }
+
+    template<std::size_t Bytes>
+    void replay_all(const std::vector<TraceRecord> &records) {
+        using Element = Payload<Bytes>;
+        {
+            ChunkList<Element, 16> list;
+            replay("ChunkList N=16", records, list);
+        }
+        {
+            ChunkList<Element, 64> list;
+            replay("ChunkList N=64", records, list);
+        }
+        {
+            ChunkList<Element, 256> list;
+            replay("ChunkList N=256", records, list);
+        }
+        {
+            ChunkList<Element, 64> list;
+            list.set_chunk_pool_limit(64);
+            replay("ChunkList N=64, pool of 64 chunks", records, list);
+        }
+        {
+            ChunkList<Element, 256, HugePageAllocator<Element>> list;
+            replay("ChunkList N=256, HugePageAllocator", records, list);
+        }
+        {
+            std::deque<Element> list;
+            replay("std::deque", records, list);
+        }
+    }
+
+    //A service queue: appends, consumers popping the front, lookups mostly near the back, now and then an
+    //insert or erase in the middle and a rare clear
+    ChunkListTraceRecorder demo_trace(std::size_t operations) {
+        ChunkListTraceRecorder recorder;
+        std::mt19937_64 random(7);
+        std::size_t size = 0;
+        auto record = [&recorder, &size](TraceOperation operation, std::size_t position) {
+            recorder.record(operation, position, size, sizeof(std::uint64_t));
+        };
+        while (recorder.size() < operations) {
+            unsigned roll = random() % 100;
+            if (roll < 40 || size == 0) {
+                record(TraceOperation::push_back, size);
+                size++;
+            } else if (roll < 65) {
+                record(TraceOperation::erase, 0);
+                size--;
+            } else if (roll < 70) {
+                record(TraceOperation::pop_back, size - 1);
+                size--;
+            } else if (roll < 95) {
+                std::size_t near_back = size - 1 - random() % std::min<std::size_t>(size, 32);
+                record(TraceOperation::access, random() % 4 == 0 ? random() % size : near_back);
+            } else if (roll < 98) {
+                record(TraceOperation::insert, random() % (size + 1));
+                size++;
+            } else if (roll < 99 || random() % 50 != 0) {
+                record(TraceOperation::erase, random() % size);
+                size--;
+            } else {
+                record(TraceOperation::clear, 0);
+                size = 0;
+            }
+        }
+        return recorder;
+    }
+}
+
+int main(int argc, char **argv) {
+    ChunkListTraceRecorder trace;
+    try {
+        if (argc == 3 && std::strcmp(argv[1], "--demo") == 0) {
+            demo_trace(1000000).save(argv[2]);
+            trace = ChunkListTraceRecorder::load(argv[2]);
+        } else if (argc == 2) {
+            trace = ChunkListTraceRecorder::load(argv[1]);
+        } else {
+            std::printf("usage: %s <trace> | --demo <trace>\n", argv[0]);
+            return 2;
+        }
+    } catch (const std::exception &error) {
+        std::printf("%s\n", error.what());
+        return 1;
+    }
+
+    std::vector<TraceRecord> records = trace.records();
+    std::size_t element_size = trace.element_size();
+    std::printf("%zu operations, %zu byte elements, %.2f bytes per operation\n", records.size(), element_size,
+                records.empty() ? 0.0 : static_cast<double>(trace.encoded_bytes()) / records.size());
+    std::printf("timer floor %lld ns, included in every latency\n\n", static_cast<long long>(timer_floor()));
+    if (element_size <= 8)
+        replay_all<8>(records);
+    else if (element_size <= 64)
+        replay_all<64>(records);
+    else
+        replay_all<256>(records);
+    return 0;
+}
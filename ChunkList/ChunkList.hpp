@@ -1,7 +1,32 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <iterator>
+#include <map>
 #include <memory>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define CHUNKLIST_HAS_READV 1
+#endif
+
+#include "ChunkListTrace.hpp"
 
 namespace fefu_laboratory_two {
     template<typename T>
@@ -32,6 +57,123 @@ namespace fefu_laboratory_two {
         void deallocate(pointer p) noexcept {
             free(p);
         }
+
+        void deallocate(pointer p, size_type) noexcept {
+            free(p);
+        }
+
+        friend bool operator==(const Allocator &, const Allocator &) noexcept {
+            return true;
+        }
+
+        friend bool operator!=(const Allocator &, const Allocator &) noexcept {
+            return false;
+        }
+    };
+
+    struct AllocationStats {
+        std::size_t allocations = 0;
+        std::size_t deallocations = 0;
+        std::size_t failed_allocations = 0;
+        std::size_t bytes_allocated = 0; //Total bytes handed out
+        std::size_t bytes_in_use = 0;
+        std::size_t peak_bytes_in_use = 0;
+        std::map<std::size_t, std::size_t> size_histogram; //Request size in bytes -> number of requests
+        std::size_t fail_at = 0; //Ordinal of the allocation that throws, 0 means never
+    };
+
+    //Allocator which records every request in an AllocationStats shared by all its copies and rebinds
+    template<typename T>
+    class CountingAllocator {
+        template<typename U>
+        friend class CountingAllocator;
+
+        std::shared_ptr<AllocationStats> log = std::make_shared<AllocationStats>();
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T *;
+        using const_pointer = const T *;
+        using reference = T &;
+        using const_reference = const T &;
+
+        CountingAllocator() = default;
+
+        CountingAllocator(const CountingAllocator &other) noexcept = default;
+
+        template<class U>
+        explicit CountingAllocator(const CountingAllocator<U> &other) noexcept : log(other.log) {}
+
+        ~CountingAllocator() = default;
+
+        pointer allocate(size_type n) {
+            std::size_t bytes = sizeof(value_type) * n;
+            log->allocations++;
+            if (log->allocations == log->fail_at) {
+                log->failed_allocations++;
+                throw std::bad_alloc();
+            }
+            pointer ptr = static_cast<pointer>(malloc(bytes));
+            if (ptr == nullptr) {
+                log->failed_allocations++;
+                throw std::bad_alloc();
+            }
+            log->bytes_allocated += bytes;
+            log->bytes_in_use += bytes;
+            if (log->bytes_in_use > log->peak_bytes_in_use)
+                log->peak_bytes_in_use = log->bytes_in_use;
+            log->size_histogram[bytes]++;
+            return ptr;
+        }
+
+        void deallocate(pointer p, size_type n) noexcept {
+            log->deallocations++;
+            log->bytes_in_use -= sizeof(value_type) * n;
+            free(p);
+        }
+
+        const AllocationStats &stats() const noexcept {
+            return *log;
+        }
+
+        //The n-th allocation from now on throws std::bad_alloc, 1 means the next one
+        void fail_nth_allocation(std::size_t n) noexcept {
+            log->fail_at = n == 0 ? 0 : log->allocations + n;
+        }
+
+        void reset() noexcept {
+            std::size_t in_use = log->bytes_in_use;
+            *log = AllocationStats();
+            log->bytes_in_use = in_use;
+            log->peak_bytes_in_use = in_use;
+        }
+
+        template<class U>
+        friend bool operator==(const CountingAllocator &left, const CountingAllocator<U> &right) noexcept {
+            return left.log == right.log;
+        }
+
+        template<class U>
+        friend bool operator!=(const CountingAllocator &left, const CountingAllocator<U> &right) noexcept {
+            return left.log != right.log;
+        }
+    };
+
+    //Summary of the live elements of one chunk for the range queries of ChunkList zone maps. Values are
+    //meaningless while count is 0
+    template<typename ValueType>
+    struct ChunkZone {
+        using sum_type = std::conditional_t<std::is_integral_v<ValueType>,
+                std::conditional_t<std::is_signed_v<ValueType>, long long, unsigned long long>,
+                std::conditional_t<std::is_same_v<ValueType, float>, double, ValueType>>;
+
+        ValueType min;
+        ValueType max;
+        sum_type sum;
+        std::size_t count = 0;
+        bool stale = false; //Set by changes the summary cannot follow, cleared by the next query reading it
     };
 
     template<typename ValueType>
@@ -85,8 +227,253 @@ namespace fefu_laboratory_two {
                 chunk[i] = other.chunk[i];
             }
         }
+
+        ~Chunk() {
+            if (chunk != nullptr)
+                allocator.deallocate(chunk);
+            delete[] dead_slots;
+            delete[] handle_slots;
+            delete zone;
+        }
+
+        std::uint64_t *dead_slots = nullptr; //Tombstone bitmap of lazy erase mode, bit set means erased. Erased elements stay alive until compaction
+        int dead_count = 0; //Tombstones below current_chunk_size
+        std::uint32_t *handle_slots = nullptr; //Handle table entry plus one of every slot in handle mode, 0 for none
+        std::uint64_t retired_epoch = 0; //Epoch the chunk was unlinked in while shared readers may still see it
+        ChunkZone<ValueType> *zone = nullptr; //Summary of the chunk while zone maps are on
+
+        static int bitmap_words(int size) noexcept {
+            return (size + 63) / 64;
+        }
+
+        static int lowest_bit(std::uint64_t word) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_ctzll(word);
+#else
+            int bit = 0;
+            while ((word & 1) == 0) {
+                word >>= 1;
+                bit++;
+            }
+            return bit;
+#endif
+        }
+
+        static int highest_bit(std::uint64_t word) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+            return 63 - __builtin_clzll(word);
+#else
+            int bit = 63;
+            while ((word >> bit) == 0)
+                bit--;
+            return bit;
+#endif
+        }
+
+        static int bit_count(std::uint64_t word) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_popcountll(word);
+#else
+            int count = 0;
+            for (; word != 0; word &= word - 1)
+                count++;
+            return count;
+#endif
+        }
+
+        int live_size() const noexcept {
+            return current_chunk_size - dead_count;
+        }
+
+        bool is_dead(int position) const noexcept {
+            return dead_count != 0 && (dead_slots[position / 64] >> (position % 64) & 1);
+        }
+
+        //First live slot at or after position, current_chunk_size when there is none
+        int next_live(int position) const noexcept {
+            if (position >= current_chunk_size)
+                return current_chunk_size;
+            if (dead_count == 0)
+                return position;
+            int word = position / 64;
+            std::uint64_t bits = ~dead_slots[word] & (~std::uint64_t(0) << (position % 64));
+            while (bits == 0) {
+                if (++word >= bitmap_words(current_chunk_size))
+                    return current_chunk_size;
+                bits = ~dead_slots[word];
+            }
+            int found = word * 64 + lowest_bit(bits);
+            return found < current_chunk_size ? found : current_chunk_size;
+        }
+
+        //Last live slot at or before position, -1 when there is none
+        int prev_live(int position) const noexcept {
+            if (position < 0 || dead_count == 0)
+                return position;
+            int word = position / 64;
+            std::uint64_t bits = ~dead_slots[word] & (~std::uint64_t(0) >> (63 - position % 64));
+            while (bits == 0) {
+                if (--word < 0)
+                    return -1;
+                bits = ~dead_slots[word];
+            }
+            return word * 64 + highest_bit(bits);
+        }
+
+        //Number of consecutive live slots starting at the live slot position
+        int live_run(int position) const noexcept {
+            if (dead_count == 0)
+                return current_chunk_size - position;
+            int word = position / 64;
+            std::uint64_t bits = dead_slots[word] & (~std::uint64_t(0) << (position % 64));
+            while (bits == 0) {
+                if (++word >= bitmap_words(current_chunk_size))
+                    return current_chunk_size - position;
+                bits = dead_slots[word];
+            }
+            int found = word * 64 + lowest_bit(bits);
+            return (found < current_chunk_size ? found : current_chunk_size) - position;
+        }
+
+        //Slot of the index-th live element
+        int live_slot(int index) const noexcept {
+            if (dead_count == 0)
+                return index;
+            for (int word = 0;; word++) {
+                std::uint64_t bits = ~dead_slots[word];
+                int count = bit_count(bits);
+                if (index < count) {
+                    for (; index > 0; index--)
+                        bits &= bits - 1;
+                    return word * 64 + lowest_bit(bits);
+                }
+                index -= count;
+            }
+        }
+
+        //Moves the live elements to the front, destroys the vacated slots and forgets the tombstones
+        void compact() {
+            if (dead_count == 0)
+                return;
+            int target = 0;
+            for (int i = 0; i < current_chunk_size; i++) {
+                if (!is_dead(i)) {
+                    if (target != i)
+                        chunk[target] = std::move(chunk[i]);
+                    target++;
+                }
+            }
+            std::destroy(chunk + target, chunk + current_chunk_size);
+            std::fill(dead_slots, dead_slots + bitmap_words(chunk_size), 0);
+            current_chunk_size = target;
+            dead_count = 0;
+        }
+    };
+
+    enum class ChunkListOperation : std::size_t {
+        access, //at, operator[], front, back
+        push,
+        pop,
+        insert,
+        erase,
+        compare,
+        other,
+        count
+    };
+
+    struct ChunkListCounters {
+        std::size_t chunk_allocations = 0;
+        std::size_t chunk_frees = 0;
+        std::array<std::size_t, static_cast<std::size_t>(ChunkListOperation::count)> walk_steps{}; //Chunk::next hops per operation
+
+        std::size_t steps(ChunkListOperation operation) const noexcept {
+            return walk_steps[static_cast<std::size_t>(operation)];
+        }
+    };
+
+    struct ChunkListStats {
+        static constexpr std::size_t fill_buckets = 11;
+
+        std::size_t chunk_count = 0;
+        std::array<std::size_t, fill_buckets> fill_histogram{}; //Bucket k holds chunks with current_chunk_size * 10 / N == k
+        std::size_t live_bytes = 0; //Bytes taken by stored elements
+        std::size_t slack_bytes = 0; //Allocated but unused element slots
+        std::size_t header_overhead = 0; //Bytes spent on Chunk headers
+        std::size_t pooled_chunks = 0; //Released chunks kept for reuse, not counted above
+        std::size_t tombstones = 0; //Erased slots waiting for compaction
+        std::size_t retired_chunks = 0; //Chunks unlinked in shared reading mode and not reclaimed yet
+        std::size_t compressed_chunks = 0; //Chunks held encoded, counted in chunk_count
+        std::size_t compressed_bytes = 0; //Memory taken by the encoded chunks
+        std::size_t compressed_raw_bytes = 0; //Size of the encoded chunks once decoded
+        std::size_t chunk_decodes = 0; //Encoded chunks decoded on access
+#ifdef CHUNKLIST_ENABLE_COUNTERS
+        ChunkListCounters counters;
+#endif
+
+        //Decoded over encoded size of the compressed chunks, 1 when there are none
+        double compression_ratio() const noexcept {
+            return compressed_bytes == 0 ? 1.0 : static_cast<double>(compressed_raw_bytes) / compressed_bytes;
+        }
+    };
+
+    //Generational reference to one element of a ChunkList in handle mode. It stays valid while the element
+    //moves between slots and chunks, and becomes stale once the element is erased
+    struct ChunkListHandle {
+        std::uint32_t index = 0;
+        std::uint32_t generation = 0; //0 is never issued, so a default handle is always stale
+
+        friend bool operator==(const ChunkListHandle &left, const ChunkListHandle &right) noexcept {
+            return left.index == right.index && left.generation == right.generation;
+        }
+
+        friend bool operator!=(const ChunkListHandle &left, const ChunkListHandle &right) noexcept {
+            return !(left == right);
+        }
     };
 
+#ifndef CHUNKLIST_PREFETCH_DISTANCE
+#define CHUNKLIST_PREFETCH_DISTANCE 2
+#endif
+
+    //How many chunks ahead of the current one traversals prefetch, 0 turns prefetching off
+    inline int chunk_prefetch_distance = CHUNKLIST_PREFETCH_DISTANCE;
+
+    inline void set_chunk_prefetch_distance(int distance) noexcept {
+        chunk_prefetch_distance = distance < 0 ? 0 : distance;
+    }
+
+    //operator[] checks its index in hardened builds and whenever assertions are on, at() always does
+#if defined(CHUNKLIST_HARDENED) || !defined(NDEBUG)
+    inline constexpr bool checked_indexing = true;
+#else
+    inline constexpr bool checked_indexing = false;
+#endif
+
+    inline void prefetch_address(const void *address) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address, 0, 3);
+#else
+        (void) address;
+#endif
+    }
+
+    //Prefetches the headers and up to data_lines cache lines of data of the chunks following current_chunk,
+    //so that walking the chain does not wait for every Chunk::next load
+    template<typename ValueType>
+    void prefetch_following_chunks(const Chunk<ValueType> *current_chunk, int data_lines = 4) noexcept {
+        const Chunk<ValueType> *ahead = current_chunk;
+        for (int i = 0; i < chunk_prefetch_distance; i++) {
+            ahead = ahead->next;
+            if (ahead == nullptr)
+                return;
+            prefetch_address(ahead);
+            const char *data = reinterpret_cast<const char *>(ahead->chunk);
+            std::size_t bytes = ahead->current_chunk_size * sizeof(ValueType);
+            for (int line = 0; line < data_lines && line * 64 < static_cast<int>(bytes); line++)
+                prefetch_address(data + line * 64);
+        }
+    }
+
     template<typename ValueType>
     class ChunkList_iterator {
     protected:
@@ -94,6 +481,47 @@ namespace fefu_laboratory_two {
         int iterator_position = 0; // Iterator position in chunk
         ValueType *current_value = nullptr;
 
+        template<typename, int, typename>
+        friend class ChunkList;
+
+        //Moves to the next live element, crossing into the next non-empty chunk, or becomes end()
+        void step_forward() {
+            if (chunk == nullptr)
+                throw std::exception();
+            int next_position = chunk->next_live(iterator_position + 1);
+            if (next_position < chunk->current_chunk_size) {
+                iterator_position = next_position;
+                current_value = &chunk->chunk[iterator_position];
+                return;
+            }
+            Chunk<ValueType> *next_chunk = chunk->next;
+            while (next_chunk != nullptr && next_chunk->live_size() == 0)
+                next_chunk = next_chunk->next;
+            if (next_chunk != nullptr)
+                prefetch_following_chunks(next_chunk);
+            chunk = next_chunk;
+            iterator_position = next_chunk == nullptr ? 0 : next_chunk->next_live(0);
+            current_value = next_chunk == nullptr ? nullptr : &next_chunk->chunk[iterator_position];
+        }
+
+        //Moves to the previous live element, or becomes end() when there is none
+        void step_backward() {
+            if (chunk == nullptr)
+                throw std::exception();
+            int prev_position = chunk->prev_live(iterator_position - 1);
+            if (prev_position >= 0) {
+                iterator_position = prev_position;
+                current_value = &chunk->chunk[iterator_position];
+                return;
+            }
+            Chunk<ValueType> *prev_chunk = chunk->prev;
+            while (prev_chunk != nullptr && prev_chunk->live_size() == 0)
+                prev_chunk = prev_chunk->prev;
+            chunk = prev_chunk;
+            iterator_position = prev_chunk == nullptr ? 0 : prev_chunk->prev_live(prev_chunk->current_chunk_size - 1);
+            current_value = prev_chunk == nullptr ? nullptr : &prev_chunk->chunk[iterator_position];
+        }
+
     public:
         using iterator_category = std::random_access_iterator_tag;
         using value_type = ValueType;
@@ -139,61 +567,24 @@ namespace fefu_laboratory_two {
         }
 
         ChunkList_iterator &operator++() {
-            if (chunk == nullptr)
-                throw std::exception();
-            int chunk_size = this->chunk->GetChunkSize();
-            if (this->iterator_position == chunk_size - 1) {
-                this->chunk = nullptr;
-                this->iterator_position = 0;
-                this->current_value = nullptr;
-                return *this;
-            } else {
-                ++iterator_position;
-                current_value = &chunk->at(iterator_position);
-                return *this;
-            }
+            step_forward();
+            return *this;
         }
 
         ChunkList_iterator operator++(int) {
-            if (chunk == nullptr)
-                throw std::exception();
             ChunkList_iterator temp(*this);
-            if (iterator_position == chunk->GetChunkSize() - 1) {
-                chunk = nullptr;
-                current_value = nullptr;
-                iterator_position = 0;
-            } else {
-                ++this->iterator_position;
-                current_value = &chunk->at(iterator_position);
-            }
+            step_forward();
             return temp;
         }
 
         ChunkList_iterator &operator--() {
-            if (chunk == nullptr)
-                throw std::exception();
-            if (this->iterator_position == 0) {
-                this->chunk = nullptr;
-                current_value = nullptr;
-                return *this;
-            } else {
-                --this->iterator_position;
-                current_value = &chunk->at(iterator_position);
-                return *this;
-            }
+            step_backward();
+            return *this;
         }
 
         ChunkList_iterator operator--(int) {
-            if (chunk == nullptr)
-                throw std::exception();
             ChunkList_iterator temp(*this);
-            if (iterator_position == 0) {
-                chunk = nullptr;
-                current_value = nullptr;
-            } else {
-                --this->iterator_position;
-                current_value = &chunk->at(iterator_position);
-            }
+            step_backward();
             return temp;
         }
 
@@ -284,6 +675,9 @@ namespace fefu_laboratory_two {
 
         ChunkList_const_iterator(const ChunkList_const_iterator &other) noexcept = default;
 
+        ChunkList_const_iterator(const ChunkList_iterator<ValueType> &other) noexcept : ChunkList_iterator<ValueType>(
+                other) {}
+
         ChunkList_const_iterator(Chunk<value_type> *current_chunk, std::size_t index, value_type *value) :
                 ChunkList_iterator<value_type>(const_cast<Chunk<value_type> *>(current_chunk), index,
                                                const_cast<value_type *>(value)) {}
@@ -298,16 +692,6 @@ namespace fefu_laboratory_two {
             std::swap(left.current_value, right.current_value);
         }
 
-        friend bool
-        operator==(const ChunkList_const_iterator<ValueType> &left, const ChunkList_const_iterator<ValueType> &right) {
-            return left.current_value == right.current_value;
-        }
-
-        friend bool
-        operator!=(const ChunkList_const_iterator<ValueType> &left, const ChunkList_const_iterator<ValueType> &right) {
-            return left.current_value != right.current_value;
-        }
-
         reference operator*() const {
             return *this->current_value;
         }
@@ -317,61 +701,24 @@ namespace fefu_laboratory_two {
         }
 
         ChunkList_const_iterator &operator++() {
-            if (this->chunk == nullptr)
-                throw std::exception();
-            int chunk_size = this->chunk->GetChunkSize();
-            if (this->iterator_position == chunk_size - 1) {
-                this->chunk = nullptr;
-                this->current_value = nullptr;
-                this->iterator_position = 0;
-                return *this;
-            } else {
-                ++this->iterator_position;
-                this->current_value = &this->chunk->at(this->iterator_position);
-                return *this;
-            }
+            this->step_forward();
+            return *this;
         }
 
         ChunkList_const_iterator operator++(int) {
-            if (this->chunk == nullptr)
-                throw std::exception();
             ChunkList_const_iterator temp(*this);
-            if (this->iterator_position == this->chunk->GetChunkSize() - 1) {
-                this->chunk = nullptr;
-                this->current_value = nullptr;
-                this->iterator_position = 0;
-            } else {
-                ++this->iterator_position;
-                this->current_value = &this->chunk->at(this->iterator_position);
-            }
+            this->step_forward();
             return temp;
         }
 
         ChunkList_const_iterator &operator--() {
-            if (this->chunk == nullptr)
-                throw std::exception();
-            if (this->iterator_position == 0) {
-                this->current_value = nullptr;
-                this->chunk = nullptr;
-                return *this;
-            } else {
-                --this->iterator_position;
-                this->current_value = &this->chunk->at(this->iterator_position);
-                return *this;
-            }
+            this->step_backward();
+            return *this;
         }
 
         ChunkList_const_iterator operator--(int) {
-            if (this->chunk == nullptr)
-                throw std::exception();
             ChunkList_const_iterator temp(*this);
-            if (this->iterator_position == 0) {
-                this->current_value = nullptr;
-                this->chunk = nullptr;
-            } else {
-                --this->iterator_position;
-                this->current_value = &this->chunk->at(this->iterator_position);
-            }
+            this->step_backward();
             return temp;
         }
 
@@ -454,241 +801,1509 @@ namespace fefu_laboratory_two {
         }
     };
 
-    template<typename T, int N, typename Allocator = Allocator<T>>
-    class ChunkList : Chunk<T> {
-    protected:
-        int chunk_list_size = 0;
-        Chunk<T> *chunks = nullptr;
+    //Owning handle to a chunk buffer moved out of or into a ChunkList. A buffer either comes from an
+    //allocator, which is what ChunkList can link in without copying, or is released by a custom deleter.
+    //The first size() slots hold live elements. An allocator buffer destroys them itself, a deleter gets
+    //them still alive
+    template<typename T, typename BufferAllocator = Allocator<T>>
+    class ChunkBuffer {
+        template<typename, int, typename>
+        friend class ChunkList;
+
+        T *buffer = nullptr;
+        std::size_t length = 0;
+        std::size_t slots = 0;
+        BufferAllocator origin;
+        bool from_allocator = false;
+        std::function<void(T *, std::size_t)> deleter; //Gets the buffer and its capacity
+
+        void reset() noexcept {
+            if (buffer != nullptr) {
+                if (from_allocator) {
+                    std::destroy(buffer, buffer + length);
+                    origin.deallocate(buffer, slots);
+                }
+                else if (deleter)
+                    deleter(buffer, slots);
+            }
+            buffer = nullptr;
+            length = 0;
+            slots = 0;
+        }
+
     public:
         using value_type = T;
-        using allocator_type = Allocator;
         using size_type = std::size_t;
-        using difference_type = std::ptrdiff_t;
-        using reference = value_type &;
-        using const_reference = const value_type &;
-        using pointer = typename std::allocator_traits<Allocator>::pointer;
-        using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
-        using iterator = ChunkList_iterator<value_type>;
-        using const_iterator = ChunkList_const_iterator<value_type>;
 
-        ChunkList() : chunks(new Chunk<T>(N)) {}
+        ChunkBuffer() = default;
 
-        explicit ChunkList(const Allocator &alloc) : chunks(new Chunk<T>(N, alloc)) {}
+        //Buffer of capacity elements from alloc, holding size of them
+        ChunkBuffer(const BufferAllocator &alloc, T *data, size_type size, size_type capacity) noexcept :
+                buffer(data), length(size), slots(capacity), origin(alloc), from_allocator(true) {}
 
-        ChunkList(size_type count, const T &value, const Allocator &alloc = Allocator()) : chunks(new Chunk<T>(N)) {
-            Chunk<value_type> *current_chunk = chunks;
-            for (chunk_list_size; chunk_list_size < count;) {
-                current_chunk->allocator = alloc;
-                for (int i = 0; i < N; i++) {
-                    if (chunk_list_size < count) {
-                        current_chunk->chunk[i] = value;
-                        current_chunk->current_chunk_size++;
-                        chunk_list_size++;
-                    } else {
-                        return;
-                    }
-                }
-                Chunk<value_type> *previous_chunk = current_chunk;
-                previous_chunk->next = new Chunk<value_type>(N, alloc);
-                current_chunk = previous_chunk->next;
-                current_chunk->prev = previous_chunk;
-            }
+        //Buffer of capacity elements filled elsewhere, released with release(data, capacity)
+        ChunkBuffer(T *data, size_type size, size_type capacity, std::function<void(T *, std::size_t)> release) :
+                buffer(data), length(size), slots(capacity), deleter(std::move(release)) {}
+
+        ChunkBuffer(const ChunkBuffer &) = delete;
+
+        ChunkBuffer &operator=(const ChunkBuffer &) = delete;
+
+        ChunkBuffer(ChunkBuffer &&other) noexcept : buffer(other.buffer), length(other.length), slots(other.slots),
+                                                     origin(other.origin), from_allocator(other.from_allocator),
+                                                     deleter(std::move(other.deleter)) {
+            other.buffer = nullptr;
+            other.length = 0;
+            other.slots = 0;
         }
 
-        explicit ChunkList(size_type count, const Allocator &alloc = Allocator()) : chunks(new Chunk<T>(N)) {
-            Chunk<value_type> *current_chunk = chunks;
-            for (chunk_list_size; chunk_list_size < count;) {
-                current_chunk->allocator = alloc;
-                for (int i = 0; i < N; i++) {
-                    if (chunk_list_size < count) {
-                        current_chunk->current_chunk_size++;
-                        chunk_list_size++;
-                    } else {
-                        return;
-                    }
-                }
-                Chunk<value_type> *previous_chunk = current_chunk;
-                previous_chunk->next = new Chunk<value_type>(N, alloc);
-                current_chunk = previous_chunk->next;
-                current_chunk->prev = previous_chunk;
+        ChunkBuffer &operator=(ChunkBuffer &&other) noexcept {
+            if (this != &other) {
+                reset();
+                buffer = other.buffer;
+                length = other.length;
+                slots = other.slots;
+                origin = other.origin;
+                from_allocator = other.from_allocator;
+                deleter = std::move(other.deleter);
+                other.buffer = nullptr;
+                other.length = 0;
+                other.slots = 0;
             }
+            return *this;
         }
 
-        ChunkList(const ChunkList &other) : chunks(new Chunk<T>(N)) {
-            Chunk<value_type> *our = chunks;
-            Chunk<value_type> *not_our = other.chunks;
-            chunk_list_size = other.chunk_list_size;
-            while (not_our != nullptr) {
-                for (int i = 0; i < not_our->current_chunk_size; i++) {
-                    our->chunk[i] = not_our->chunk[i];
-                    our->current_chunk_size++;
-                }
-                Chunk<value_type> *next_chunk = new Chunk<T>(N);
-                next_chunk->prev = our;
-                our->next = next_chunk;
-                our = next_chunk;
-                not_our = not_our->next;
-            }
+        ~ChunkBuffer() {
+            reset();
         }
 
-        ChunkList(const ChunkList &other, const Allocator &alloc) : chunks(new Chunk<value_type>(N,alloc)){
-            Chunk<value_type> *our = chunks;
-            Chunk<value_type> *not_our = other.chunks;
-            chunk_list_size = other.chunk_list_size;
-            while (not_our != nullptr) {
-                for (int i = 0; i < not_our->current_chunk_size; i++) {
-                    our->chunk[i] = not_our->chunk[i];
-                    our->current_chunk_size++;
-                }
-                Chunk<value_type> *next_chunk = new Chunk<T>(N, alloc);
-                next_chunk->prev = our;
-                our->next = next_chunk;
-                our = next_chunk;
-                not_our = not_our->next;
-            }
+        T *data() const noexcept {
+            return buffer;
         }
 
-        ChunkList(ChunkList &&other) {
-            chunks = std::move(other.chunks);
-            chunk_list_size = std::move(other.chunk_list_size);
-            other.chunks = nullptr;
-            other.chunk_list_size = 0;
+        size_type size() const noexcept {
+            return length;
         }
 
-        ChunkList(ChunkList &&other, const Allocator &alloc) : chunks(other.chunks),
-                                                               chunk_list_size(other.chunk_list_size) {
-            Chunk<value_type> *current_chunk = this->chunks;
-            while (current_chunk != nullptr) {
-                current_chunk->allocator = alloc;
-                current_chunk = current_chunk->next;
-            }
-            other.chunk_list_size = 0;
-            other.chunks = nullptr;
+        size_type capacity() const noexcept {
+            return slots;
         }
 
-        ChunkList(std::initializer_list<T> init, const Allocator &alloc = Allocator()) {
-            if (init.size() == 0) return;
-            chunks = new Chunk(alloc);
+        bool empty() const noexcept {
+            return length == 0;
+        }
 
-            auto it = init.begin();
+        //Constructs an element in the first free slot
+        template<class... Args>
+        T &emplace_back(Args &&... args) {
+            if (length == slots) throw std::length_error("Buffer is full");
+            T *slot = ::new(static_cast<void *>(buffer + length)) T(std::forward<Args>(args)...);
+            length++;
+            return *slot;
+        }
 
-            for (; it != init.end(); ++it)
-                push_back(*it);
+        //Declares how many leading elements a producer has constructed in place
+        void set_size(size_type size) {
+            if (size > slots) throw std::length_error("Buffer size exceeds its capacity");
+            length = size;
         }
 
-        ~ChunkList() = default;
+        T &operator[](size_type pos) const noexcept {
+            return buffer[pos];
+        }
 
-        ChunkList &operator=(const ChunkList &other) {
-            this = new ChunkList(other);
-            return *this;
+        T *begin() const noexcept {
+            return buffer;
         }
 
-        ChunkList &operator=(ChunkList &&other) {
-            chunks = std::move(other.chunks);
-            chunk_list_size = std::move(other.chunk_list_size);
-            other.clear();
-            return *this;
+        T *end() const noexcept {
+            return buffer + length;
         }
+    };
 
-        ChunkList &operator=(std::initializer_list<T> ilist) {
-            auto it = ilist.begin();
+    //What a ChunkList in shared reading mode publishes to reader threads: the bounds of the committed
+    //elements, written under a sequence lock, and the epoch every live snapshot is pinned at. Chunks the writer
+    //unlinks are reclaimed only once no snapshot pinned at or before their retirement is left
+    template<typename T>
+    struct ChunkListSharedState {
+        static constexpr std::size_t max_readers = 64;
 
-            for (; it != ilist.end(); ++it) push_back(*it);
-            return *this;
+        struct alignas(64) Pin {
+            std::atomic<std::uint64_t> epoch{0}; //0 while the slot is free
         };
 
-        void assign(size_type count, const T &value) {
-            if (count > 0) {
-                clear();
-                for (size_type i = 0; i < count; i++) push_back(value);
-                chunk_list_size = count;
-            }
-        };
+        std::atomic<std::uint64_t> sequence{0}; //Odd while the writer is publishing
+        std::atomic<Chunk<T> *> head{nullptr};
+        std::atomic<int> head_slot{0}; //Slot of the first element in head
+        std::atomic<Chunk<T> *> tail{nullptr};
+        std::atomic<int> tail_count{0}; //Committed slots of tail
+        std::atomic<int> size{0};
+        alignas(64) std::atomic<std::uint64_t> epoch{1};
+        std::array<Pin, max_readers> pins;
+    };
 
-        void assign(std::initializer_list<T> ilist) {
-            if (ilist.size() == 0) return;
-            clear();
+    //Elements of a ChunkList in shared reading mode as they were published when the snapshot was taken. The
+    //writer may go on appending and popping from the front: the chunks the snapshot covers stay in place
+    //until it is destroyed. It must not outlive the list
+    template<typename T>
+    class ChunkListSnapshot {
+        template<typename, int, typename>
+        friend class ChunkList;
 
-            auto it = ilist.begin();
+        ChunkListSharedState<T> *state = nullptr;
+        std::size_t pin = 0;
+        const Chunk<T> *head = nullptr;
+        int head_slot = 0;
+        const Chunk<T> *tail = nullptr;
+        int tail_count = 0;
+        std::size_t length = 0;
 
-            for (; it != ilist.end(); ++it) push_back(*it);
+        void reset() noexcept {
+            if (state != nullptr)
+                state->pins[pin].epoch.store(0, std::memory_order_release);
+            state = nullptr;
+            length = 0;
+        }
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+
+        ChunkListSnapshot() = default;
+
+        ChunkListSnapshot(const ChunkListSnapshot &) = delete;
+
+        ChunkListSnapshot &operator=(const ChunkListSnapshot &) = delete;
+
+        ChunkListSnapshot(ChunkListSnapshot &&other) noexcept : state(other.state), pin(other.pin), head(other.head),
+                                                                 head_slot(other.head_slot), tail(other.tail),
+                                                                 tail_count(other.tail_count), length(other.length) {
+            other.state = nullptr;
+            other.length = 0;
+        }
+
+        ChunkListSnapshot &operator=(ChunkListSnapshot &&other) noexcept {
+            if (this != &other) {
+                reset();
+                state = other.state;
+                pin = other.pin;
+                head = other.head;
+                head_slot = other.head_slot;
+                tail = other.tail;
+                tail_count = other.tail_count;
+                length = other.length;
+                other.state = nullptr;
+                other.length = 0;
+            }
+            return *this;
+        }
+
+        ~ChunkListSnapshot() {
+            reset();
+        }
+
+        size_type size() const noexcept {
+            return length;
+        }
+
+        bool empty() const noexcept {
+            return length == 0;
+        }
+
+        //Passes every contiguous stretch of elements to on_run(first, length), front to back
+        template<typename RunVisitor>
+        void for_each_run(RunVisitor on_run) const {
+            if (length == 0)
+                return;
+            const Chunk<T> *current_chunk = head;
+            int position = head_slot;
+            for (;;) {
+                int end = current_chunk == tail ? tail_count : current_chunk->current_chunk_size;
+                if (position < end)
+                    on_run(static_cast<const T *>(current_chunk->chunk + position), end - position);
+                if (current_chunk == tail)
+                    return;
+                current_chunk = current_chunk->next;
+                position = 0;
+            }
+        }
+
+        template<typename Visitor>
+        void for_each(Visitor visit) const {
+            for_each_run([&visit](const T *first, int run_length) {
+                for (int i = 0; i < run_length; i++)
+                    visit(first[i]);
+            });
+        }
+    };
+
+    template<typename T, int N, typename Allocator = Allocator<T>>
+    class ChunkList : Chunk<T> {
+    protected:
+#ifdef CHUNKLIST_ENABLE_COUNTERS
+        mutable ChunkListCounters counters;
+#endif
+#ifdef CHUNKLIST_ENABLE_TRACE
+        ChunkListTraceRecorder *trace_recorder = nullptr; //Not owned, swap() leaves it with this object
+#endif
+        //Everything allocate_chunk() touches is declared before chunks, which constructors initialize with it
+        Allocator chunk_allocator;
+        Chunk<T> *spare_chunks = nullptr; //Released chunks kept for reuse, linked through next
+        std::size_t spare_chunks_count = 0;
+        std::size_t chunk_pool_limit = 0;
+        bool lazy_erase = false;
+        double tombstone_threshold = 0.25; //Share of tombstones in a chunk which triggers its compaction
+        bool handle_mode = false;
+        bool zone_maps = false;
+        int chunk_list_size = 0;
+        Chunk<T> *chunks = nullptr;
+        mutable Chunk<T> *last_chunk = nullptr; //End of the chain, unless last_chunk_stale
+        mutable bool last_chunk_stale = true;
+        std::size_t ring_capacity = 0; //Newest elements ring mode keeps, 0 when it is off
+        mutable Chunk<T> *finger_chunk = nullptr; //Chunk of the last indexed access, nullptr when unknown
+        mutable std::size_t finger_base = 0; //Index of the first live element of finger_chunk
+        std::vector<unsigned char> ingest_carry; //Leading bytes of an element append_from_fd() has not got whole
+        ChunkListSharedState<T> *shared_reads = nullptr; //Set in shared reading mode
+        Chunk<T> *retired_chunks = nullptr; //Oldest chunk awaiting reclamation, linked through prev to newer ones
+        Chunk<T> *newest_retired = nullptr;
+        std::size_t retired_count = 0;
+
+        struct Fence {
+            T first;
+            T last;
+            Chunk<T> *chunk;
         };
 
-        allocator_type get_allocator() const noexcept {
-            return chunks->allocator;
+        bool sorted_mode = false;
+        bool fences_stale = true;
+        std::vector<Fence> fences; //First and last key of every non-empty chunk, in chain order
+
+        static constexpr std::uint32_t no_handle = ~std::uint32_t(0);
+
+        struct HandleEntry {
+            Chunk<T> *chunk; //nullptr while the entry is free
+            int slot;
+            std::uint32_t generation;
+            std::uint32_t next_free;
+        };
+
+        std::vector<HandleEntry> handle_table;
+        std::uint32_t free_handle = no_handle; //Head of the free entries, linked through next_free
+
+        //Gives a chunk which was allocated earlier, possibly by another list, the per-slot tables the modes
+        //of this list need
+        void prepare_chunk(Chunk<T> *reused_chunk) {
+            if (lazy_erase && reused_chunk->dead_slots == nullptr)
+                reused_chunk->dead_slots = new std::uint64_t[Chunk<T>::bitmap_words(N)]();
+            if (handle_mode && reused_chunk->handle_slots == nullptr)
+                reused_chunk->handle_slots = new std::uint32_t[N]();
+            if (zone_maps && reused_chunk->zone == nullptr)
+                reused_chunk->zone = new_zone();
+            reset_zone(reused_chunk);
+        }
+
+        Chunk<T> *allocate_chunk() {
+            if (spare_chunks != nullptr) {
+                Chunk<T> *reused_chunk = spare_chunks;
+                prepare_chunk(reused_chunk);
+                spare_chunks = reused_chunk->next;
+                spare_chunks_count--;
+                reused_chunk->next = nullptr;
+                return reused_chunk;
+            }
+            auto *new_chunk = new Chunk<T>();
+            try {
+                new_chunk->chunk = chunk_allocator.allocate(N);
+                if (lazy_erase)
+                    new_chunk->dead_slots = new std::uint64_t[Chunk<T>::bitmap_words(N)]();
+                if (handle_mode)
+                    new_chunk->handle_slots = new std::uint32_t[N]();
+                if (zone_maps)
+                    new_chunk->zone = new_zone();
+            } catch (...) {
+                if (new_chunk->chunk != nullptr)
+                    chunk_allocator.deallocate(new_chunk->chunk, N);
+                new_chunk->chunk = nullptr;
+                delete new_chunk;
+                throw;
+            }
+            new_chunk->chunk_size = N;
+#ifdef CHUNKLIST_ENABLE_COUNTERS
+            counters.chunk_allocations++;
+#endif
+            return new_chunk;
+        }
+
+        void free_chunk(Chunk<T> *old_chunk) noexcept {
+            chunk_allocator.deallocate(old_chunk->chunk, old_chunk->chunk_size);
+            old_chunk->chunk = nullptr;
+            delete old_chunk;
+#ifdef CHUNKLIST_ENABLE_COUNTERS
+            counters.chunk_frees++;
+#endif
+        }
+
+        //Destroys the elements of a chunk and pools or frees it. In shared reading mode the chunk is only retired,
+        //since snapshots may still read it, and reclaimed by a later publication
+        void release_chunk(Chunk<T> *old_chunk) noexcept {
+            forget_finger();
+            if (shared_reads != nullptr) {
+                old_chunk->retired_epoch = shared_reads->epoch.load(std::memory_order_relaxed);
+                old_chunk->prev = nullptr; //next stays intact for readers walking past the chunk
+                if (newest_retired == nullptr)
+                    retired_chunks = old_chunk;
+                else
+                    newest_retired->prev = old_chunk;
+                newest_retired = old_chunk;
+                retired_count++;
+                return;
+            }
+            reclaim_chunk(old_chunk);
+        }
+
+        void reclaim_chunk(Chunk<T> *old_chunk) noexcept {
+            std::destroy(old_chunk->chunk, old_chunk->chunk + old_chunk->current_chunk_size);
+            if (spare_chunks_count < chunk_pool_limit) {
+                if (old_chunk->dead_slots != nullptr)
+                    std::fill(old_chunk->dead_slots, old_chunk->dead_slots + Chunk<T>::bitmap_words(N), 0);
+                if (old_chunk->handle_slots != nullptr)
+                    std::fill(old_chunk->handle_slots, old_chunk->handle_slots + N, 0);
+                old_chunk->dead_count = 0;
+                old_chunk->current_chunk_size = 0;
+                old_chunk->prev = nullptr;
+                old_chunk->next = spare_chunks;
+                spare_chunks = old_chunk;
+                spare_chunks_count++;
+                return;
+            }
+            free_chunk(old_chunk);
+        }
+
+        //Element types whose equality is exactly equality of their bytes
+        static constexpr bool bytewise_comparable = std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>;
+
+        //Walks both chains in lockstep and passes every stretch that is contiguous in both lists to
+        //on_run(left, right, length), whatever the chunk boundaries are. Stops early when on_run returns false
+        template<typename RunVisitor>
+        static bool for_each_common_run(const ChunkList &lhs, const ChunkList &rhs, RunVisitor on_run) {
+            const Chunk<T> *left_chunk = lhs.chunks;
+            const Chunk<T> *right_chunk = rhs.chunks;
+            int left_position = 0;
+            int right_position = 0;
+            int remaining = lhs.chunk_list_size < rhs.chunk_list_size ? lhs.chunk_list_size : rhs.chunk_list_size;
+            if (remaining > 0) {
+                prefetch_following_chunks(left_chunk);
+                prefetch_following_chunks(right_chunk);
+            }
+            while (remaining > 0) {
+                while ((left_position = left_chunk->next_live(left_position)) == left_chunk->current_chunk_size) {
+                    left_chunk = left_chunk->next;
+                    left_position = 0;
+                    prefetch_following_chunks(left_chunk);
+                    lhs.count_walk_step(ChunkListOperation::compare);
+                }
+                while ((right_position = right_chunk->next_live(right_position)) == right_chunk->current_chunk_size) {
+                    right_chunk = right_chunk->next;
+                    right_position = 0;
+                    prefetch_following_chunks(right_chunk);
+                    rhs.count_walk_step(ChunkListOperation::compare);
+                }
+                int length = left_chunk->live_run(left_position);
+                if (right_chunk->live_run(right_position) < length)
+                    length = right_chunk->live_run(right_position);
+                if (remaining < length)
+                    length = remaining;
+                if (!on_run(left_chunk->chunk + left_position, right_chunk->chunk + right_position, length))
+                    return false;
+                left_position += length;
+                right_position += length;
+                remaining -= length;
+            }
+            return true;
         }
 
-        reference at(size_type pos) {
-            Chunk<value_type> *current_chunk = chunks;
-            int count = 0;
+        struct MergeRun {
+            Chunk<T> *chunk = nullptr; //Chunk currently read
+            int position = 0;
+            Chunk<T> *last = nullptr; //Last chunk of the run
+            ChunkList *owner = nullptr;
+        };
+
+        template<typename Compare, typename ChunkSorter>
+        void sort_chunks(Compare &comp, ChunkSorter sort_chunk) {
+            if (chunk_list_size < 2)
+                return;
+            drop_all_handles();
+            compact();
+            std::vector<MergeRun> runs;
+            Chunk<T> *current_chunk = chunks;
             while (current_chunk != nullptr) {
-                count++;
-                current_chunk = current_chunk->next;
+                Chunk<T> *next_chunk = current_chunk->next;
+                if (current_chunk->current_chunk_size == 0) {
+                    release_chunk(current_chunk);
+                } else {
+                    sort_chunk(current_chunk->chunk, current_chunk->chunk + current_chunk->current_chunk_size, comp);
+                    runs.push_back({current_chunk, 0, current_chunk, this});
+                }
+                current_chunk = next_chunk;
             }
-            int chunk_pos = pos / N;
-            int elem_pos = pos % N;
-            if (pos >= N * count || pos < 0) throw std::out_of_range("Out of bounds");
+            chunks = nullptr;
+            merge_runs(runs, comp, chunk_list_size);
+        }
 
-            Chunk<value_type> *temp = chunks;
-            for (int i = 0; i < chunk_pos; i++) {
-                temp = temp->next;
+        //Adds the whole chain of list as one run, skipping empty chunks
+        static void add_chain_run(std::vector<MergeRun> &runs, ChunkList &list) {
+            Chunk<T> *first = list.chunks;
+            while (first != nullptr && first->current_chunk_size == 0)
+                first = first->next;
+            if (first == nullptr)
+                return;
+            Chunk<T> *last = first;
+            for (Chunk<T> *current_chunk = first; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                if (current_chunk->current_chunk_size != 0)
+                    last = current_chunk;
             }
-            return temp->chunk[elem_pos];
+            runs.push_back({first, 0, last, &list});
         }
 
-        const_reference at(size_type pos) const {
-            Chunk<value_type> *current_chunk = chunks;
-            int count = 0;
+        //Releases the empty chunks of a detached chain, which merge_runs would otherwise never see
+        void release_empty_chunks(Chunk<T> *current_chunk) noexcept {
             while (current_chunk != nullptr) {
-                count++;
+                Chunk<T> *next_chunk = current_chunk->next;
+                if (current_chunk->current_chunk_size == 0) {
+                    if (current_chunk->prev != nullptr)
+                        current_chunk->prev->next = next_chunk;
+                    if (next_chunk != nullptr)
+                        next_chunk->prev = current_chunk->prev;
+                    release_chunk(current_chunk);
+                }
+                current_chunk = next_chunk;
+            }
+        }
+
+        //Merges sorted runs into a fresh chain which replaces chunks. Drained chunks are reused for the output,
+        //so the extra memory stays within a chunk or so unless the runs drain very unevenly
+        template<typename Compare>
+        void merge_runs(std::vector<MergeRun> &runs, Compare &comp, int total_size) {
+            forget_finger();
+            auto goes_after = [&runs, &comp](std::size_t left, std::size_t right) {
+                const T &left_value = runs[left].chunk->chunk[runs[left].position];
+                const T &right_value = runs[right].chunk->chunk[runs[right].position];
+                if (comp(right_value, left_value))
+                    return true;
+                if (comp(left_value, right_value))
+                    return false;
+                return right < left; //Earlier runs win ties, which keeps the merge stable
+            };
+
+            std::vector<std::size_t> heap;
+            for (std::size_t i = 0; i < runs.size(); i++)
+                heap.push_back(i);
+            std::make_heap(heap.begin(), heap.end(), goes_after);
+
+            std::vector<Chunk<T> *> drained_chunks;
+            Chunk<T> *head = nullptr;
+            Chunk<T> *tail = nullptr;
+            try {
+                while (!heap.empty()) {
+                    std::pop_heap(heap.begin(), heap.end(), goes_after);
+                    MergeRun &run = runs[heap.back()];
+                    if (tail == nullptr || tail->current_chunk_size == N) {
+                        Chunk<T> *output_chunk;
+                        if (drained_chunks.empty()) {
+                            output_chunk = allocate_chunk();
+                        } else {
+                            output_chunk = drained_chunks.back();
+                            prepare_chunk(output_chunk); //Drained chunks of other come without our tables
+                            drained_chunks.pop_back();
+                            output_chunk->next = nullptr;
+                        }
+                        output_chunk->prev = tail;
+                        if (tail == nullptr)
+                            head = output_chunk;
+                        else
+                            tail->next = output_chunk;
+                        tail = output_chunk;
+                    }
+                    construct_slot(tail, tail->current_chunk_size, std::move(run.chunk->chunk[run.position]));
+                    tail->current_chunk_size++;
+                    run.position++;
+
+                    bool has_more = true;
+                    while (has_more && run.position == run.chunk->current_chunk_size) {
+                        Chunk<T> *drained = run.chunk;
+                        has_more = drained != run.last;
+                        run.chunk = drained->next;
+                        run.position = 0;
+                        if (run.owner == this || run.owner->chunk_allocator == chunk_allocator) {
+                            std::destroy(drained->chunk, drained->chunk + drained->current_chunk_size);
+                            drained->current_chunk_size = 0;
+                            drained_chunks.push_back(drained);
+                        } else
+                            run.owner->release_chunk(drained);
+                    }
+                    if (has_more)
+                        std::push_heap(heap.begin(), heap.end(), goes_after);
+                    else
+                        heap.pop_back();
+                }
+            } catch (...) {
+                //Keep every element: the merged prefix goes first, then what is left of each run
+                for (std::size_t index : heap) {
+                    MergeRun &run = runs[index];
+                    Chunk<T> *current_chunk = run.chunk;
+                    int shift = run.position;
+                    while (true) {
+                        Chunk<T> *next_chunk = current_chunk->next;
+                        for (int i = shift; i < current_chunk->current_chunk_size; i++)
+                            current_chunk->chunk[i - shift] = std::move(current_chunk->chunk[i]);
+                        std::destroy(current_chunk->chunk + current_chunk->current_chunk_size - shift,
+                                     current_chunk->chunk + current_chunk->current_chunk_size);
+                        current_chunk->current_chunk_size -= shift;
+                        shift = 0;
+                        current_chunk->prev = tail;
+                        current_chunk->next = nullptr;
+                        if (tail == nullptr)
+                            head = current_chunk;
+                        else
+                            tail->next = current_chunk;
+                        tail = current_chunk;
+                        if (current_chunk == run.last)
+                            break;
+                        current_chunk = next_chunk;
+                    }
+                }
+                chunks = head;
+                last_chunk = tail;
+                last_chunk_stale = false;
+                chunk_list_size = total_size;
+                fences_stale = true;
+                touch_all_zones();
+                for (Chunk<T> *drained : drained_chunks)
+                    release_chunk(drained);
+                throw;
+            }
+            chunks = head;
+            last_chunk = tail;
+            last_chunk_stale = false;
+            chunk_list_size = total_size;
+            fences_stale = true;
+            touch_all_zones();
+            for (Chunk<T> *drained : drained_chunks)
+                release_chunk(drained);
+        }
+
+        //Finds the chunk holding element pos, which must be below chunk_list_size, and turns pos into
+        //the slot inside that chunk. Chunks are not necessarily full, so this walks by their live elements,
+        //starting from the finger of the previous access when it is closer than the head, or jumping straight
+        //to the last chunk. Sequential indexing thus moves at most one chunk per access
+        Chunk<T> *locate(std::size_t &pos, ChunkListOperation operation) const noexcept {
+            Chunk<T> *current_chunk = chunks;
+            std::size_t base = 0;
+            if (!last_chunk_stale && pos >= chunk_list_size - last_chunk->live_size()) {
+                current_chunk = last_chunk;
+                base = chunk_list_size - last_chunk->live_size();
+            } else if (finger_chunk != nullptr && pos + pos >= finger_base) {
+                current_chunk = finger_chunk;
+                base = finger_base;
+                while (pos < base) {
+                    current_chunk = current_chunk->prev;
+                    base -= current_chunk->live_size();
+                    count_walk_step(operation);
+                }
+            }
+            while (pos - base >= static_cast<std::size_t>(current_chunk->live_size())) {
+                base += current_chunk->live_size();
+                current_chunk = current_chunk->next;
+                count_walk_step(operation);
+            }
+            finger_chunk = current_chunk;
+            finger_base = base;
+            pos = current_chunk->live_slot(static_cast<int>(pos - base));
+            return current_chunk;
+        }
+
+        //Zone maps exist for arithmetic elements only, so that other element types need neither a default
+        //constructor nor arithmetic
+        static ChunkZone<T> *new_zone() {
+            if constexpr (std::is_arithmetic_v<T>)
+                return new ChunkZone<T>();
+            else
+                return nullptr;
+        }
+
+        static void reset_zone(Chunk<T> *current_chunk) noexcept {
+            if (current_chunk->zone != nullptr) {
+                current_chunk->zone->count = 0;
+                current_chunk->zone->stale = false;
+            }
+        }
+
+        //Leaves the summary of a chunk whose elements changed wholesale to the next query
+        void touch_zone(Chunk<T> *current_chunk) const noexcept {
+            if (zone_maps)
+                current_chunk->zone->stale = true;
+        }
+
+        void touch_all_zones() const noexcept {
+            if (!zone_maps)
+                return;
+            for (Chunk<T> *current_chunk = chunks; current_chunk != nullptr; current_chunk = current_chunk->next)
+                current_chunk->zone->stale = true;
+        }
+
+        void zone_add(Chunk<T> *current_chunk, const T &value) const noexcept {
+            if constexpr (std::is_arithmetic_v<T>) {
+                if (!zone_maps || current_chunk->zone->stale)
+                    return;
+                ChunkZone<T> &zone = *current_chunk->zone;
+                if (zone.count == 0) {
+                    zone.min = value;
+                    zone.max = value;
+                    zone.sum = value;
+                } else {
+                    if (value < zone.min)
+                        zone.min = value;
+                    if (zone.max < value)
+                        zone.max = value;
+                    zone.sum += value;
+                }
+                zone.count++;
+            }
+        }
+
+        //Removing the minimum or the maximum, or any floating-point value, whose sum would drift by rounding,
+        //leaves the summary stale
+        void zone_remove(Chunk<T> *current_chunk, const T &value) const noexcept {
+            if constexpr (std::is_arithmetic_v<T>) {
+                if (!zone_maps || current_chunk->zone->stale)
+                    return;
+                ChunkZone<T> &zone = *current_chunk->zone;
+                zone.count--;
+                if constexpr (std::is_integral_v<T>)
+                    zone.sum -= value;
+                if (zone.count != 0 && (!std::is_integral_v<T> || !(zone.min < value) || !(value < zone.max)))
+                    zone.stale = true;
+            }
+        }
+
+        //Summary of a chunk, recomputed first when it is stale
+        const ChunkZone<T> &zone_of(Chunk<T> *current_chunk) const noexcept {
+            ChunkZone<T> &zone = *current_chunk->zone;
+            if (zone.stale) {
+                zone.count = 0;
+                zone.stale = false;
+                for (int position = current_chunk->next_live(0); position < current_chunk->current_chunk_size;
+                     position = current_chunk->next_live(position + 1))
+                    zone_add(current_chunk, current_chunk->chunk[position]);
+            }
+            return zone;
+        }
+
+        //Passes the elements at positions first up to last chunk by chunk: on_chunk(chunk) gets the chunks
+        //the range covers whole and on_run(elements, length) the covered parts of the two edge chunks
+        template<typename WholeChunk, typename Run>
+        void visit_range(std::size_t first, std::size_t last, WholeChunk on_chunk, Run on_run) const {
+            if (first > last || last > static_cast<std::size_t>(chunk_list_size))
+                throw std::out_of_range("Out of bounds");
+            std::size_t remaining = last - first;
+            if (remaining == 0)
+                return;
+            std::size_t slot = first;
+            Chunk<T> *current_chunk = locate(slot, ChunkListOperation::access);
+            int position = static_cast<int>(slot);
+            while (true) {
+                std::size_t live = current_chunk->live_size();
+                if (position == current_chunk->next_live(0) && live <= remaining) {
+                    if (live != 0)
+                        on_chunk(current_chunk);
+                    remaining -= live;
+                } else {
+                    while (remaining > 0 && (position = current_chunk->next_live(position)) < current_chunk->current_chunk_size) {
+                        std::size_t length = std::min<std::size_t>(current_chunk->live_run(position), remaining);
+                        on_run(static_cast<const T *>(current_chunk->chunk + position), length);
+                        position += static_cast<int>(length);
+                        remaining -= length;
+                    }
+                }
+                if (remaining == 0)
+                    return;
+                current_chunk = current_chunk->next;
+                position = 0;
+                count_walk_step(ChunkListOperation::access);
+            }
+        }
+
+        //Reclaims the retired chunks unlinked before epoch
+        void reclaim_retired(std::uint64_t epoch) noexcept {
+            while (retired_chunks != nullptr && retired_chunks->retired_epoch < epoch) {
+                Chunk<T> *old_chunk = retired_chunks;
+                retired_chunks = old_chunk->prev;
+                if (retired_chunks == nullptr)
+                    newest_retired = nullptr;
+                old_chunk->prev = nullptr;
+                old_chunk->retired_epoch = 0;
+                retired_count--;
+                reclaim_chunk(old_chunk);
+            }
+        }
+
+        //Stores the bounds of the committed elements for snapshots to pick up. Once they are out, no new
+        //snapshot can reach the chunks retired so far, so the epoch advances and the retired chunks no live
+        //snapshot is pinned at or before are reclaimed
+        void publish_bounds() noexcept {
+            if (shared_reads == nullptr)
+                return;
+            Chunk<T> *head = chunks;
+            int head_slot = 0;
+            Chunk<T> *tail = nullptr;
+            int tail_count = 0;
+            if (head != nullptr) {
+                while (head->live_size() == 0 && head->next != nullptr)
+                    head = head->next;
+                head_slot = head->next_live(0);
+                tail = back_chunk(ChunkListOperation::other);
+                tail_count = tail->current_chunk_size;
+            }
+            ChunkListSharedState<T> &state = *shared_reads;
+            std::uint64_t sequence = state.sequence.load(std::memory_order_relaxed);
+            state.sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            state.head.store(head, std::memory_order_relaxed);
+            state.head_slot.store(head_slot, std::memory_order_relaxed);
+            state.tail.store(tail, std::memory_order_relaxed);
+            state.tail_count.store(tail_count, std::memory_order_relaxed);
+            state.size.store(chunk_list_size, std::memory_order_relaxed);
+            state.sequence.store(sequence + 2, std::memory_order_release);
+            if (retired_chunks == nullptr)
+                return;
+
+            //Orders the bounds before the pins: a snapshot pinned too late for the scan to see reads the new bounds
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::uint64_t oldest = state.epoch.fetch_add(1) + 1;
+            for (const typename ChunkListSharedState<T>::Pin &pin : state.pins) {
+                std::uint64_t pinned = pin.epoch.load();
+                if (pinned != 0 && pinned < oldest)
+                    oldest = pinned;
+            }
+            reclaim_retired(oldest);
+        }
+
+        //Called by everything that changes how many elements sit in front of a chunk or releases one
+        void forget_finger() const noexcept {
+            finger_chunk = nullptr;
+        }
+
+        void rebuild_fences() {
+            fences.clear();
+            for (Chunk<T> *current_chunk = chunks; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                if (current_chunk->live_size() != 0)
+                    fences.push_back({current_chunk->chunk[current_chunk->next_live(0)],
+                                      current_chunk->chunk[current_chunk->current_chunk_size - 1], current_chunk});
+            }
+            fences_stale = false;
+        }
+
+        void refresh_fence(std::size_t index) {
+            Chunk<T> *fenced_chunk = fences[index].chunk;
+            fences[index].first = fenced_chunk->chunk[fenced_chunk->next_live(0)];
+            fences[index].last = fenced_chunk->chunk[fenced_chunk->current_chunk_size - 1];
+        }
+
+        void require_zone_maps() const {
+            if (!zone_maps)
+                throw std::logic_error("Zone maps are off");
+        }
+
+        const std::vector<Fence> &sorted_fences() const {
+            if (!sorted_mode)
+                throw std::runtime_error("Not in sorted mode");
+            if (fences_stale)
+                const_cast<ChunkList *>(this)->rebuild_fences();
+            return fences;
+        }
+
+        //Iterator to element position of chunk, where position == current_chunk_size means the next element
+        static ChunkList_iterator<T> iterator_at(Chunk<T> *current_chunk, int position) {
+            position = current_chunk->next_live(position);
+            if (position == current_chunk->current_chunk_size) {
                 current_chunk = current_chunk->next;
+                while (current_chunk != nullptr && current_chunk->live_size() == 0)
+                    current_chunk = current_chunk->next;
+                if (current_chunk == nullptr)
+                    return ChunkList_iterator<T>();
+                position = current_chunk->next_live(0);
+            }
+            return ChunkList_iterator<T>(current_chunk, position, &current_chunk->chunk[position]);
+        }
+
+        //Last chunk, or a newly linked one when it is full. The slot at current_chunk_size is free for the
+        //caller to fill before commit_back()
+        Chunk<T> *back_chunk_with_room() {
+            if (chunks == nullptr) {
+                chunks = allocate_chunk();
+                last_chunk = chunks;
+                last_chunk_stale = false;
+            }
+
+            Chunk<T> *current_chunk = back_chunk(ChunkListOperation::push);
+            if (current_chunk->current_chunk_size == current_chunk->chunk_size) {
+                if (ring_capacity != 0 && chunks != current_chunk && chunks->live_size() == 0) {
+                    current_chunk = recycle_head_chunk();
+                } else {
+                    current_chunk->next = allocate_chunk();
+                    current_chunk->next->prev = current_chunk;
+                    current_chunk = current_chunk->next;
+                }
+                last_chunk = current_chunk;
+            }
+            return current_chunk;
+        }
+
+        //Last chunk of the chain, walked to only after the chain has been rebuilt
+        Chunk<T> *back_chunk(ChunkListOperation operation) const noexcept {
+            if (last_chunk_stale) {
+                last_chunk = chunks;
+                while (last_chunk != nullptr && last_chunk->next != nullptr) {
+                    last_chunk = last_chunk->next;
+                    count_walk_step(operation);
+                }
+                last_chunk_stale = false;
+            }
+            return last_chunk;
+        }
+
+        //Destroys the evicted elements of the first chunk and moves it, emptied, to the end of the chain
+        Chunk<T> *recycle_head_chunk() noexcept {
+            forget_finger();
+            Chunk<T> *oldest = chunks;
+            for (int i = 0; i < oldest->current_chunk_size; i++)
+                drop_handle(oldest, i);
+            chunk_list_size -= oldest->live_size();
+            std::destroy(oldest->chunk, oldest->chunk + oldest->current_chunk_size);
+            if (oldest->dead_slots != nullptr)
+                std::fill(oldest->dead_slots, oldest->dead_slots + Chunk<T>::bitmap_words(N), 0);
+            oldest->dead_count = 0;
+            oldest->current_chunk_size = 0;
+            reset_zone(oldest);
+            chunks = oldest->next;
+            chunks->prev = nullptr;
+            oldest->prev = last_chunk;
+            oldest->next = nullptr;
+            last_chunk->next = oldest;
+            fences_stale = true;
+            return oldest;
+        }
+
+        void commit_back(Chunk<T> *current_chunk) noexcept {
+            current_chunk->current_chunk_size++;
+            chunk_list_size++;
+            fences_stale = true;
+        }
+
+        //Slots below current_chunk_size hold live objects and the rest is raw memory, so elements are
+        //constructed in place and destroyed when they leave
+        template<class... Args>
+        static T *construct_slot(Chunk<T> *current_chunk, int slot, Args &&... args) {
+            return ::new(static_cast<void *>(current_chunk->chunk + slot)) T(std::forward<Args>(args)...);
+        }
+
+        //Constructs an element at position of a chunk with room and no tombstones, shifting the elements from
+        //position on one slot right. When construction throws, the shifted elements are moved back
+        template<class... Args>
+        void construct_shifted(Chunk<T> *current_chunk, int position, Args &&... args) {
+            T *slots = current_chunk->chunk;
+            int last = current_chunk->current_chunk_size;
+            if (position == last) {
+                construct_slot(current_chunk, position, std::forward<Args>(args)...);
+            } else {
+                construct_slot(current_chunk, last, std::move(slots[last - 1]));
+                std::move_backward(slots + position, slots + last - 1, slots + last);
+                std::destroy_at(slots + position);
+                try {
+                    construct_slot(current_chunk, position, std::forward<Args>(args)...);
+                } catch (...) {
+                    construct_slot(current_chunk, position, std::move(slots[position + 1]));
+                    std::move(slots + position + 2, slots + last + 1, slots + position + 1);
+                    std::destroy_at(slots + last);
+                    throw;
+                }
+            }
+            for (int i = last; i > position; i--)
+                carry_handle(current_chunk, i - 1, current_chunk, i);
+            current_chunk->current_chunk_size++;
+            zone_add(current_chunk, slots[position]);
+        }
+
+        //Moves the elements of a chunk without tombstones from slot keep on into a new chunk linked after it
+        Chunk<T> *split_chunk(Chunk<T> *target, int keep) {
+            Chunk<T> *new_chunk = allocate_chunk();
+            try {
+                std::uninitialized_move(target->chunk + keep, target->chunk + target->current_chunk_size,
+                                        new_chunk->chunk);
+            } catch (...) {
+                release_chunk(new_chunk);
+                throw;
+            }
+            for (int i = keep; i < target->current_chunk_size; i++)
+                carry_handle(target, i, new_chunk, i - keep);
+            std::destroy(target->chunk + keep, target->chunk + target->current_chunk_size);
+            new_chunk->current_chunk_size = target->current_chunk_size - keep;
+            target->current_chunk_size = keep;
+            new_chunk->prev = target;
+            new_chunk->next = target->next;
+            if (target->next != nullptr)
+                target->next->prev = new_chunk;
+            target->next = new_chunk;
+            if (!last_chunk_stale && last_chunk == target)
+                last_chunk = new_chunk;
+            touch_zone(target);
+            touch_zone(new_chunk);
+            return new_chunk;
+        }
+
+        //Drops tombstones at the end of the chunk, so that its last slot is always live
+        static void trim_dead_tail(Chunk<T> *current_chunk) noexcept {
+            while (current_chunk->current_chunk_size > 0 && current_chunk->is_dead(current_chunk->current_chunk_size - 1)) {
+                int last = --current_chunk->current_chunk_size;
+                std::destroy_at(current_chunk->chunk + last);
+                current_chunk->dead_slots[last / 64] &= ~(std::uint64_t(1) << (last % 64));
+                current_chunk->dead_count--;
+            }
+        }
+
+        void unlink_chunk(Chunk<T> *old_chunk) noexcept {
+            if (old_chunk->next == nullptr)
+                last_chunk = old_chunk->prev;
+            if (old_chunk->prev != nullptr)
+                old_chunk->prev->next = old_chunk->next;
+            else
+                chunks = old_chunk->next;
+            if (old_chunk->next != nullptr)
+                old_chunk->next->prev = old_chunk->prev;
+            release_chunk(old_chunk);
+        }
+
+        //Moves the handle of slot from of from_chunk, if there is one, along with the element to slot to of to_chunk
+        void carry_handle(Chunk<T> *from_chunk, int from, Chunk<T> *to_chunk, int to) noexcept {
+            if (!handle_mode)
+                return;
+            std::uint32_t entry = from_chunk->handle_slots[from];
+            from_chunk->handle_slots[from] = 0;
+            to_chunk->handle_slots[to] = entry;
+            if (entry != 0) {
+                handle_table[entry - 1].chunk = to_chunk;
+                handle_table[entry - 1].slot = to;
+            }
+        }
+
+        //Makes the handle of an element about to be removed stale
+        void drop_handle(Chunk<T> *current_chunk, int slot) noexcept {
+            if (!handle_mode || current_chunk->handle_slots[slot] == 0)
+                return;
+            std::uint32_t index = current_chunk->handle_slots[slot] - 1;
+            current_chunk->handle_slots[slot] = 0;
+            HandleEntry &entry = handle_table[index];
+            entry.chunk = nullptr;
+            if (++entry.generation == 0)
+                entry.generation = 1;
+            entry.next_free = free_handle;
+            free_handle = index;
+        }
+
+        void drop_all_handles() noexcept {
+            for (HandleEntry &entry : handle_table) {
+                if (entry.chunk != nullptr)
+                    drop_handle(entry.chunk, entry.slot);
+            }
+        }
+
+        //Squeezes the tombstones out of a chunk, taking the handles along
+        void compact_chunk(Chunk<T> *current_chunk) {
+            if (handle_mode && current_chunk->dead_count != 0) {
+                int target = 0;
+                for (int i = 0; i < current_chunk->current_chunk_size; i++) {
+                    if (!current_chunk->is_dead(i))
+                        carry_handle(current_chunk, i, current_chunk, target++);
+                }
+            }
+            current_chunk->compact();
+        }
+
+        //Evicts the oldest elements beyond ring_capacity. They are marked erased and stay alive until their
+        //chunk is recycled, so an element being pushed may still refer to one. A first chunk left with only
+        //evicted elements waits for push_back to reuse it, chunks evicted whole behind it are released
+        void trim_ring() noexcept {
+            if (ring_capacity == 0 || chunk_list_size <= ring_capacity)
+                return;
+            forget_finger();
+            fences_stale = true;
+            while (chunk_list_size > ring_capacity) {
+                Chunk<T> *oldest = chunks->live_size() == 0 ? chunks->next : chunks;
+                if (oldest->next != nullptr && chunk_list_size - oldest->live_size() > ring_capacity) {
+                    for (int i = 0; i < oldest->current_chunk_size; i++)
+                        drop_handle(oldest, i);
+                    chunk_list_size -= oldest->live_size();
+                    unlink_chunk(oldest);
+                    continue;
+                }
+                int position = oldest->next_live(0);
+                drop_handle(oldest, position);
+                zone_remove(oldest, oldest->chunk[position]);
+                oldest->dead_slots[position / 64] |= std::uint64_t(1) << (position % 64);
+                oldest->dead_count++;
+                chunk_list_size--;
+            }
+        }
+
+        //Appends elements up to count, filling the last chunk and then whole new ones. construct(first, length)
+        //constructs length elements in raw slots
+        template<typename Construct>
+        void grow(std::size_t count, Construct construct) {
+            if (chunks == nullptr) {
+                chunks = allocate_chunk();
+                last_chunk = chunks;
+                last_chunk_stale = false;
+            }
+            Chunk<T> *current_chunk = back_chunk(ChunkListOperation::push);
+            fences_stale = true;
+            try {
+                while (chunk_list_size < count) {
+                    if (current_chunk->current_chunk_size == N) {
+                        current_chunk->next = allocate_chunk();
+                        current_chunk->next->prev = current_chunk;
+                        current_chunk = current_chunk->next;
+                        last_chunk = current_chunk;
+                    }
+                    int room = N - current_chunk->current_chunk_size;
+                    int length = count - chunk_list_size < static_cast<size_type>(room) ?
+                                 static_cast<int>(count - chunk_list_size) : room;
+                    construct(current_chunk->chunk + current_chunk->current_chunk_size, length);
+                    current_chunk->current_chunk_size += length;
+                    chunk_list_size += length;
+                    touch_zone(current_chunk);
+                }
+            } catch (...) {
+                if (current_chunk->current_chunk_size == 0 && current_chunk != chunks)
+                    unlink_chunk(current_chunk);
+                throw;
+            }
+            trim_ring();
+        }
+
+        //Drops elements from the back down to count, releasing whole chunks without touching them one by one
+        //unless they need destructors or handles
+        void truncate(std::size_t count) noexcept {
+            Chunk<T> *current_chunk = back_chunk(ChunkListOperation::pop);
+            fences_stale = true;
+            while (chunk_list_size > count) {
+                size_type excess = chunk_list_size - count;
+                int first_dropped = 0;
+                if (static_cast<size_type>(current_chunk->live_size()) > excess || current_chunk == chunks) {
+                    compact_chunk(current_chunk);
+                    first_dropped = current_chunk->current_chunk_size - static_cast<int>(excess);
+                }
+                if (handle_mode) {
+                    for (int i = first_dropped; i < current_chunk->current_chunk_size; i++)
+                        drop_handle(current_chunk, i);
+                }
+                if (first_dropped == 0 && current_chunk != chunks) {
+                    Chunk<T> *previous_chunk = current_chunk->prev;
+                    chunk_list_size -= current_chunk->live_size();
+                    unlink_chunk(current_chunk);
+                    current_chunk = previous_chunk;
+                } else {
+                    std::destroy(current_chunk->chunk + first_dropped, current_chunk->chunk + current_chunk->current_chunk_size);
+                    current_chunk->current_chunk_size = first_dropped;
+                    chunk_list_size = count;
+                    touch_zone(current_chunk);
+                }
+            }
+        }
+
+        //Replaces the contents with count elements, reusing the chunks in chain order and allocating or
+        //releasing only the difference. overwrite(first, index, length) assigns over live slots and
+        //construct(first, index, length) constructs in raw ones, index being where first lands in the list
+        template<typename Overwrite, typename Construct>
+        void refill(std::size_t count, Overwrite overwrite, Construct construct) {
+            forget_finger();
+            drop_all_handles();
+            compact();
+            fences_stale = true;
+            size_type filled = 0;
+            Chunk<T> *previous_chunk = nullptr;
+            Chunk<T> *current_chunk = chunks;
+            try {
+                while (filled < count) {
+                    int target = count - filled < static_cast<size_type>(N) ? static_cast<int>(count - filled) : N;
+                    if (current_chunk == nullptr) {
+                        current_chunk = allocate_chunk();
+                        try {
+                            construct(current_chunk->chunk, filled, target);
+                        } catch (...) {
+                            release_chunk(current_chunk);
+                            throw;
+                        }
+                        current_chunk->prev = previous_chunk;
+                        if (previous_chunk == nullptr)
+                            chunks = current_chunk;
+                        else
+                            previous_chunk->next = current_chunk;
+                    } else {
+                        int live = current_chunk->current_chunk_size;
+                        overwrite(current_chunk->chunk, filled, live < target ? live : target);
+                        if (live < target)
+                            construct(current_chunk->chunk + live, filled + live, target - live);
+                        else
+                            std::destroy(current_chunk->chunk + target, current_chunk->chunk + live);
+                    }
+                    current_chunk->current_chunk_size = target;
+                    touch_zone(current_chunk);
+                    filled += target;
+                    previous_chunk = current_chunk;
+                    current_chunk = current_chunk->next;
+                }
+            } catch (...) {
+                chunk_list_size = 0;
+                for (Chunk<T> *counted = chunks; counted != nullptr; counted = counted->next)
+                    chunk_list_size += counted->live_size();
+                last_chunk_stale = true;
+                touch_all_zones();
+                throw;
+            }
+
+            if (previous_chunk == nullptr) {
+                clear();
+                return;
+            }
+            previous_chunk->next = nullptr;
+            while (current_chunk != nullptr) {
+                Chunk<T> *next_chunk = current_chunk->next;
+                release_chunk(current_chunk);
+                current_chunk = next_chunk;
+            }
+            chunk_list_size = static_cast<int>(count);
+            last_chunk = previous_chunk;
+            last_chunk_stale = false;
+            trim_ring();
+        }
+
+        //Index of the first live element of current_chunk. Walks out both ways from the finger, or from the head
+        //when there is none, and leaves the finger on current_chunk, so that operations on neighbouring
+        //positions cost a step or two
+        std::size_t chunk_base(const Chunk<T> *current_chunk) const noexcept {
+            if (!last_chunk_stale && current_chunk == last_chunk)
+                return chunk_list_size - last_chunk->live_size();
+            Chunk<T> *ahead = finger_chunk != nullptr ? finger_chunk : chunks;
+            std::size_t ahead_base = finger_chunk != nullptr ? finger_base : 0;
+            Chunk<T> *behind = ahead;
+            std::size_t behind_base = ahead_base;
+            while (ahead != current_chunk && behind != current_chunk) {
+                if (ahead != nullptr) {
+                    ahead_base += ahead->live_size();
+                    ahead = ahead->next;
+                }
+                if (behind != nullptr) {
+                    behind = behind->prev;
+                    if (behind != nullptr)
+                        behind_base -= behind->live_size();
+                }
+            }
+            finger_chunk = ahead == current_chunk ? ahead : behind;
+            finger_base = ahead == current_chunk ? ahead_base : behind_base;
+            return finger_base;
+        }
+
+        //Records an operation on the element at slot position of current_chunk, nullptr meaning end()
+        void trace_operation(TraceOperation operation, const Chunk<T> *current_chunk, int position) const noexcept {
+#ifdef CHUNKLIST_ENABLE_TRACE
+            if (trace_recorder == nullptr)
+                return;
+            std::size_t index = chunk_list_size;
+            if (current_chunk != nullptr) {
+                index = chunk_base(current_chunk);
+                for (int i = 0; i < position; i++)
+                    index += current_chunk->is_dead(i) ? 0 : 1;
+            }
+            trace_recorder->record(operation, index, chunk_list_size, sizeof(T));
+#else
+            (void) operation;
+            (void) current_chunk;
+            (void) position;
+#endif
+        }
+
+        void trace_operation(TraceOperation operation, std::size_t index) const noexcept {
+#ifdef CHUNKLIST_ENABLE_TRACE
+            if (trace_recorder != nullptr)
+                trace_recorder->record(operation, index, chunk_list_size, sizeof(T));
+#else
+            (void) operation;
+            (void) index;
+#endif
+        }
+
+        //Copies the live elements of other into the empty first chunk and new ones behind it, keeping the
+        //chunk boundaries of other
+        void copy_elements(const ChunkList &other) {
+            sorted_mode = other.sorted_mode;
+            Chunk<value_type> *our = chunks;
+            Chunk<value_type> *not_our = other.chunks;
+            chunk_list_size = other.chunk_list_size;
+            try {
+                while (not_our != nullptr) {
+                    prefetch_following_chunks(not_our);
+                    for (int i = 0; i < not_our->current_chunk_size; i++) {
+                        if (not_our->is_dead(i))
+                            continue;
+                        construct_slot(our, our->current_chunk_size, not_our->chunk[i]);
+                        our->current_chunk_size++;
+                    }
+                    not_our = not_our->next;
+                    if (not_our == nullptr)
+                        break;
+                    Chunk<value_type> *next_chunk = allocate_chunk();
+                    next_chunk->prev = our;
+                    our->next = next_chunk;
+                    our = next_chunk;
+                }
+            } catch (...) {
+                abandon_construction();
+                throw;
+            }
+        }
+
+        //Frees whatever a constructor built before it threw, since the destructor does not run for it
+        void abandon_construction() noexcept {
+            clear();
+            set_chunk_pool_limit(0);
+        }
+
+        void count_walk_step(ChunkListOperation operation) const noexcept {
+#ifdef CHUNKLIST_ENABLE_COUNTERS
+            counters.walk_steps[static_cast<std::size_t>(operation)]++;
+#else
+            (void) operation;
+#endif
+        }
+
+    public:
+        using value_type = T;
+        using allocator_type = Allocator;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type &;
+        using const_reference = const value_type &;
+        using pointer = typename std::allocator_traits<Allocator>::pointer;
+        using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
+        using iterator = ChunkList_iterator<value_type>;
+        using const_iterator = ChunkList_const_iterator<value_type>;
+        using buffer_type = ChunkBuffer<value_type, Allocator>;
+        using snapshot_type = ChunkListSnapshot<value_type>;
+        using sum_type = typename ChunkZone<value_type>::sum_type;
+
+        ChunkList() : chunks(allocate_chunk()) {}
+
+        explicit ChunkList(const Allocator &alloc) : chunk_allocator(alloc), chunks(allocate_chunk()) {}
+
+        ChunkList(size_type count, const T &value, const Allocator &alloc = Allocator()) : chunk_allocator(alloc),
+                                                                                            chunks(allocate_chunk()) {
+            try {
+                resize(count, value);
+            } catch (...) {
+                abandon_construction();
+                throw;
+            }
+        }
+
+        explicit ChunkList(size_type count, const Allocator &alloc = Allocator()) : chunk_allocator(alloc),
+                                                                                     chunks(allocate_chunk()) {
+            try {
+                resize(count);
+            } catch (...) {
+                abandon_construction();
+                throw;
+            }
+        }
+
+        ChunkList(const ChunkList &other) : chunk_allocator(other.chunk_allocator), chunks(allocate_chunk()) {
+            copy_elements(other);
+        }
+
+        ChunkList(const ChunkList &other, const Allocator &alloc) : chunk_allocator(alloc), chunks(allocate_chunk()) {
+            copy_elements(other);
+        }
+
+        ChunkList(ChunkList &&other) : chunk_allocator(other.chunk_allocator) {
+            swap(other);
+        }
+
+        ChunkList(ChunkList &&other, const Allocator &alloc) : chunk_allocator(alloc) {
+            if (chunk_allocator == other.chunk_allocator) {
+                swap(other);
+                return;
+            }
+            Chunk<value_type> *current_chunk = other.chunks;
+            try {
+                while (current_chunk != nullptr) {
+                    for (int i = 0; i < current_chunk->current_chunk_size; i++) {
+                        if (!current_chunk->is_dead(i))
+                            push_back(std::move(current_chunk->chunk[i]));
+                    }
+                    current_chunk = current_chunk->next;
+                }
+            } catch (...) {
+                abandon_construction();
+                throw;
+            }
+            other.clear();
+        }
+
+        ChunkList(std::initializer_list<T> init, const Allocator &alloc = Allocator()) : chunk_allocator(alloc) {
+            if (init.size() == 0) return;
+            chunks = allocate_chunk();
+
+            try {
+                for (const T &value : init)
+                    push_back(value);
+            } catch (...) {
+                abandon_construction();
+                throw;
+            }
+        }
+
+        ~ChunkList() {
+#ifdef CHUNKLIST_ENABLE_TRACE
+            trace_recorder = nullptr; //The recorder may already be gone
+#endif
+            clear();
+            disable_shared_reading();
+            set_chunk_pool_limit(0);
+        }
+
+        ChunkList &operator=(const ChunkList &other) {
+            if (this != &other) {
+                ChunkList copy(other);
+                swap(copy);
             }
-            int chunk_pos = pos / N;
-            int elem_pos = pos % N;
-            if (pos >= N * count || pos < 0) throw std::out_of_range("Out of bounds");
+            return *this;
+        }
+
+        ChunkList &operator=(ChunkList &&other) {
+            if (this != &other) {
+                clear();
+                swap(other);
+            }
+            return *this;
+        }
+
+        ChunkList &operator=(std::initializer_list<T> ilist) {
+            assign(ilist);
+            return *this;
+        };
+
+        //Overwrites the elements in place: the chunks already there are reused, and only the chunks count
+        //needs beyond them are allocated or the ones it leaves empty released
+        void assign(size_type count, const T &value) {
+            refill(count, [&value](T *first, size_type, int length) { std::fill_n(first, length, value); },
+                   [&value](T *first, size_type, int length) { std::uninitialized_fill_n(first, length, value); });
+        };
 
-            Chunk<value_type> *temp = chunks;
-            for (int i = 0; i < chunk_pos; i++) {
-                temp = temp->next;
+        void assign(std::initializer_list<T> ilist) {
+            const T *source = ilist.begin();
+            refill(ilist.size(),
+                   [source](T *first, size_type index, int length) { std::copy_n(source + index, length, first); },
+                   [source](T *first, size_type index, int length) {
+                       std::uninitialized_copy_n(source + index, length, first);
+                   });
+        };
+
+        allocator_type get_allocator() const noexcept {
+            return chunk_allocator;
+        }
+
+        //Keep up to limit released chunks for reuse instead of returning them to the allocator
+        void set_chunk_pool_limit(size_type limit) noexcept {
+            chunk_pool_limit = limit;
+            while (spare_chunks_count > chunk_pool_limit) {
+                Chunk<value_type> *extra_chunk = spare_chunks;
+                spare_chunks = extra_chunk->next;
+                spare_chunks_count--;
+                free_chunk(extra_chunk);
             }
-            return temp->chunk[elem_pos];
         }
 
+        size_type chunk_pool_size() const noexcept {
+            return spare_chunks_count;
+        }
+
+        reference at(size_type pos) {
+            if (pos >= chunk_list_size) throw std::out_of_range("Out of bounds");
+            return operator[](pos);
+        }
+
+        const_reference at(size_type pos) const {
+            if (pos >= chunk_list_size) throw std::out_of_range("Out of bounds");
+            return operator[](pos);
+        }
+
+        //Unchecked unless checked_indexing is on
         reference operator[](size_type pos) {
-            return at(pos);
+            if constexpr (checked_indexing) {
+                if (pos >= chunk_list_size) throw std::out_of_range("Out of bounds");
+            }
+            trace_operation(TraceOperation::access, pos);
+            Chunk<value_type> *current_chunk = locate(pos, ChunkListOperation::access);
+            return current_chunk->chunk[pos];
         }
 
         const_reference operator[](size_type pos) const {
-            return at(pos);
+            if constexpr (checked_indexing) {
+                if (pos >= chunk_list_size) throw std::out_of_range("Out of bounds");
+            }
+            trace_operation(TraceOperation::access, pos);
+            Chunk<value_type> *current_chunk = locate(pos, ChunkListOperation::access);
+            return current_chunk->chunk[pos];
         }
 
         reference front() {
-            return chunk_list_size ? chunks->chunk[0] : throw std::runtime_error("Empty");
+            if (chunk_list_size == 0) throw std::runtime_error("Empty");
+            trace_operation(TraceOperation::access, 0);
+            size_type position = 0;
+            Chunk<value_type> *first_chunk = locate(position, ChunkListOperation::access);
+            return first_chunk->chunk[position];
         }
 
         const_reference front() const {
-            return chunk_list_size ? static_cast<reference>(chunks->chunk[0]) : throw std::runtime_error("Empty");
+            if (chunk_list_size == 0) throw std::runtime_error("Empty");
+            trace_operation(TraceOperation::access, 0);
+            size_type position = 0;
+            Chunk<value_type> *first_chunk = locate(position, ChunkListOperation::access);
+            return first_chunk->chunk[position];
         }
 
         reference back() {
             if (chunk_list_size == 0) throw std::runtime_error("Empty");
-            Chunk<value_type> *current_chunk = chunks;
-            while (current_chunk->next != nullptr) current_chunk = current_chunk->next;
+            trace_operation(TraceOperation::access, chunk_list_size - 1);
+            Chunk<value_type> *current_chunk = back_chunk(ChunkListOperation::access);
             return current_chunk->chunk[current_chunk->current_chunk_size - 1];
         }
 
         const_reference back() const {
             if (chunk_list_size == 0) throw std::runtime_error("Empty");
-            Chunk<value_type> *current_chunk = chunks;
-            while (current_chunk->next != nullptr) current_chunk = current_chunk->next;
-            return const_cast<reference>(current_chunk->chunk[current_chunk->current_chunk_size - 1]);
+            trace_operation(TraceOperation::access, chunk_list_size - 1);
+            Chunk<value_type> *current_chunk = back_chunk(ChunkListOperation::access);
+            return current_chunk->chunk[current_chunk->current_chunk_size - 1];
         }
 
         iterator begin() noexcept {
             if (!chunk_list_size) {
                 return end();
             }
-            ChunkList_const_iterator<value_type> iter1(this->chunks, 0, &at(0));
+            size_type position = 0;
+            Chunk<value_type> *first_chunk = locate(position, ChunkListOperation::access);
+            prefetch_following_chunks(first_chunk);
+            ChunkList_const_iterator<value_type> iter1(first_chunk, position, first_chunk->chunk + position);
             return iter1;
         }
 
@@ -697,7 +2312,10 @@ namespace fefu_laboratory_two {
                 return end();
             }
 
-            ChunkList_const_iterator<value_type> iter1(this->chunks, 0, &at(0));
+            size_type position = 0;
+            Chunk<value_type> *first_chunk = locate(position, ChunkListOperation::access);
+            prefetch_following_chunks(first_chunk);
+            ChunkList_const_iterator<value_type> iter1(first_chunk, position, first_chunk->chunk + position);
             return iter1;
         }
 
@@ -729,191 +2347,274 @@ namespace fefu_laboratory_two {
             return (chunk_list_size % N) == 0 ? chunk_list_size : (chunk_list_size + N - chunk_list_size % N);
         }
 
-        void shrink_to_fit() {
+        ChunkListStats stats() const noexcept {
+            ChunkListStats result;
             Chunk<value_type> *current_chunk = chunks;
-
-            while (current_chunk->next != nullptr) {
+            while (current_chunk != nullptr) {
+                result.chunk_count++;
+                result.fill_histogram[current_chunk->live_size() * 10 / N]++;
+                result.slack_bytes += (current_chunk->chunk_size - current_chunk->current_chunk_size) * sizeof(value_type);
+                result.tombstones += current_chunk->dead_count;
                 current_chunk = current_chunk->next;
             }
+            result.live_bytes = chunk_list_size * sizeof(value_type);
+            result.header_overhead = result.chunk_count * sizeof(Chunk<value_type>);
+            result.pooled_chunks = spare_chunks_count;
+            result.retired_chunks = retired_count;
+#ifdef CHUNKLIST_ENABLE_COUNTERS
+            result.counters = counters;
+#endif
+            return result;
+        }
+
+#ifdef CHUNKLIST_ENABLE_COUNTERS
+        void reset_counters() noexcept {
+            counters = ChunkListCounters();
+        }
+#endif
+
+#ifdef CHUNKLIST_ENABLE_TRACE
+        //Logs every later element operation on this list into recorder, nullptr stops logging. Iteration and
+        //whole-list changes (assignment, assign, resize, swap, merge, adopt_back, append_from_fd, ring eviction)
+        //are not logged. The list does not own recorder, which must outlive it or be detached first. The
+        //destructor logs nothing
+        void set_trace_recorder(ChunkListTraceRecorder *recorder) noexcept {
+            trace_recorder = recorder;
+        }
+#endif
+
+        void shrink_to_fit() {
+            if (chunks == nullptr)
+                return;
+            Chunk<value_type> *current_chunk = back_chunk(ChunkListOperation::other);
 
-            while (current_chunk->current_chunk_size == 0) {
+            while (current_chunk->current_chunk_size == 0 && current_chunk != chunks) {
+                Chunk<value_type> *empty_chunk = current_chunk;
                 current_chunk = current_chunk->prev;
                 current_chunk->next = nullptr;
+                release_chunk(empty_chunk);
             }
+            last_chunk = current_chunk;
         }
 
         void clear() noexcept {
+            trace_operation(TraceOperation::clear, 0);
+            forget_finger();
+            drop_all_handles();
             Chunk<value_type> *current_chunk = chunks;
             while (current_chunk != nullptr) {
+                prefetch_following_chunks(current_chunk, 1); //Brings in the header of the next chunk before this one is released
                 Chunk<value_type>* temp_pointer = current_chunk;
                 current_chunk = current_chunk->next;
-                delete temp_pointer;
+                release_chunk(temp_pointer);
             }
             chunk_list_size = 0;
             chunks = nullptr;
+            last_chunk = nullptr;
+            last_chunk_stale = false;
+            fences_stale = true;
+            publish_bounds();
         }
 
+        //A value that lives in the chunk about to shift is copied out first
         iterator insert(const_iterator pos, const T &value) {
-            push_back(value_type());
-            ChunkList_const_iterator<value_type> iter(this, chunk_list_size - 1, &at(chunk_list_size - 1));
-
-            bool flag = true; // Dislocated by 1 to right
-            while (flag) {
-                *iter = *(iter - 1);
-                iter--;
-                if (iter == pos)
-                    flag = false;
-            }
-
-            *iter = value;
-            return iter;
+            Chunk<value_type> *target = pos.chunk;
+            std::less<const value_type *> before;
+            if (target != nullptr && !before(&value, target->chunk) && before(&value, target->chunk + N))
+                return emplace(pos, value_type(value));
+            return emplace(pos, value);
         }
 
         iterator insert(const_iterator pos, T &&value) {
-            push_back(value_type());
-            ChunkList_const_iterator<value_type> iter(this, chunk_list_size - 1, &at(chunk_list_size - 1));
-
-            bool flag = true; // Dislocated by 1 to right
-            while (flag) {
-                *iter = *(iter - 1);
-                iter--;
-                if (iter == pos)
-                    flag = false;
-            }
-
-            *iter = std::move(value);
-            return iter;
+            return emplace(pos, std::move(value));
         }
 
         iterator insert(const_iterator pos, size_type count, const T &value) {
             if (count == 0) return pos;
 
-            ChunkList_const_iterator<value_type> iter(this, pos.iterator_position, at(pos.iterator_position));
-
-            for (int i = 0; i < count; i++)
-                insert(pos, value);
-
-            return iter;
+            iterator first = insert(pos, value);
+            for (size_type i = 1; i < count; i++)
+                first = insert(first, value);
+            return first;
         }
 
         iterator insert(const_iterator pos, std::initializer_list<T> ilist) {
-            if (empty(ilist))
-                return pos;
-
-            ChunkList_const_iterator<value_type> iter(this, pos.iterator_position, at(pos.iterator_position));
-
-            T current_element = ilist.end() - 1;
-
-            bool flag = true;
-            while (flag) {
-                insert(pos, *current_element);
-                if (current_element == ilist.begin()) {
-                    flag = false;
-                    break;
-                }
-                current_element--;
-            }
-            return iter;
+            iterator first = pos;
+            for (auto current_element = ilist.end(); current_element != ilist.begin();)
+                first = insert(first, *--current_element);
+            return first;
         }
 
+        //Constructs one element from args right in its slot in front of pos. Only the chunk of pos shifts; when
+        //it is full, the element goes to the end of the previous chunk or a new one in front if pos is the
+        //first slot, and otherwise the chunk is split in two. Args must not refer to elements of that chunk
         template<class... Args>
         iterator emplace(const_iterator pos, Args &&... args) {
-            auto data = { std::forward<Args>(args)... };
-            ChunkList_const_iterator<value_type> iter(this, pos.iterator_position, &at(pos.iterator_position));
+            Chunk<value_type> *target = pos.chunk;
+            if (target == nullptr) {
+                emplace_back(std::forward<Args>(args)...);
+                Chunk<value_type> *current_chunk = back_chunk(ChunkListOperation::insert);
+                return iterator_at(current_chunk, current_chunk->current_chunk_size - 1);
+            }
+            int position = pos.iterator_position;
+            trace_operation(TraceOperation::insert, target, position);
+            if (finger_chunk != target) //Inserting into the finger's chunk or splitting it keeps its base
+                forget_finger();
+            if (target->dead_count != 0) {
+                int live_before = 0;
+                for (int i = 0; i < position; i++)
+                    live_before += target->is_dead(i) ? 0 : 1;
+                compact_chunk(target);
+                position = live_before;
+            }
 
-            for (auto i : data)
-                insert(pos, i);
+            if (target->current_chunk_size == N) {
+                if (position != 0) {
+                    int keep = position <= N / 2 ? N / 2 : (N + 1) / 2;
+                    Chunk<value_type> *new_chunk = split_chunk(target, keep);
+                    if (position > keep) {
+                        target = new_chunk;
+                        position -= keep;
+                    }
+                } else if (target->prev != nullptr && target->prev->current_chunk_size < N) {
+                    forget_finger();
+                    target = target->prev;
+                    position = target->current_chunk_size;
+                } else {
+                    Chunk<value_type> *new_chunk = allocate_chunk();
+                    try {
+                        construct_slot(new_chunk, 0, std::forward<Args>(args)...);
+                    } catch (...) {
+                        release_chunk(new_chunk);
+                        throw;
+                    }
+                    forget_finger();
+                    new_chunk->current_chunk_size = 1;
+                    zone_add(new_chunk, new_chunk->chunk[0]);
+                    new_chunk->next = target;
+                    new_chunk->prev = target->prev;
+                    if (target->prev != nullptr)
+                        target->prev->next = new_chunk;
+                    else
+                        chunks = new_chunk;
+                    target->prev = new_chunk;
+                    chunk_list_size++;
+                    fences_stale = true;
+                    return iterator_at(new_chunk, 0);
+                }
+            }
 
-            return iter;
+            construct_shifted(target, position, std::forward<Args>(args)...);
+            chunk_list_size++;
+            fences_stale = true;
+            return iterator_at(target, position);
         }
 
+        //Removes the element inside its chunk: shifts the rest of the chunk, or in lazy erase mode only marks
+        //a tombstone. Chunks left without elements are released
         iterator erase(const_iterator pos) {
-            ChunkList_const_iterator<value_type> iter(this, pos.iterator_position, &at(pos.iterator_position));
-
-            while (true) {
-                *iter = *(iter +1);
-                iter++;
-                if (iter.iterator_position == chunk_list_size - 1) break;
+            Chunk<value_type> *current_chunk = pos.chunk;
+            int position = pos.iterator_position;
+            if (current_chunk == nullptr)
+                throw std::out_of_range("Out of bounds");
+            trace_operation(TraceOperation::erase, current_chunk, position);
+            if (finger_chunk != current_chunk) //Erasing inside the finger's chunk keeps its base
+                forget_finger();
+
+            drop_handle(current_chunk, position);
+            zone_remove(current_chunk, current_chunk->chunk[position]);
+            if (lazy_erase) {
+                current_chunk->dead_slots[position / 64] |= std::uint64_t(1) << (position % 64);
+                current_chunk->dead_count++;
+                trim_dead_tail(current_chunk);
+            } else {
+                for (int i = position + 1; i < current_chunk->current_chunk_size; i++)
+                    current_chunk->chunk[i - 1] = std::move(current_chunk->chunk[i]);
+                std::destroy_at(current_chunk->chunk + current_chunk->current_chunk_size - 1);
+                if (handle_mode) {
+                    for (int i = position + 1; i < current_chunk->current_chunk_size; i++)
+                        carry_handle(current_chunk, i, current_chunk, i - 1);
+                }
+                current_chunk->current_chunk_size--;
             }
-
             chunk_list_size--;
+            fences_stale = true;
 
-            ChunkList_const_iterator<value_type> iter1(this, pos.iterator_position, &at(pos.iterator_position));
-            return iter1;
+            if (current_chunk->live_size() == 0 && (current_chunk != chunks || current_chunk->next != nullptr)) {
+                Chunk<value_type> *next_chunk = current_chunk->next;
+                unlink_chunk(current_chunk);
+                return next_chunk == nullptr ? end() : iterator_at(next_chunk, 0);
+            }
+            if (lazy_erase && current_chunk->dead_count > tombstone_threshold * current_chunk->current_chunk_size) {
+                int live_before = 0; //Where the element after the erased one lands
+                for (int i = 0; i < position; i++)
+                    live_before += current_chunk->is_dead(i) ? 0 : 1;
+                compact_chunk(current_chunk);
+                return iterator_at(current_chunk, live_before);
+            }
+            return iterator_at(current_chunk, position);
         }
 
         iterator erase(const_iterator first, const_iterator last) {
-            auto t = last.iterator_position - first.iterator_position;
-
-            ChunkList_const_iterator<value_type> iter(this, first.iterator_position, &at(first.iterator_position));
+            size_type count = 0;
+            for (const_iterator current = first; current != last; ++current)
+                count++;
 
-            for (int i = 0; i < t; i++)
-                erase(first+1);
+            iterator current = first;
+            for (size_type i = 0; i < count; i++)
+                current = erase(current);
 
-            return iter;
+            return current;
         }
 
         void push_back(const T &value) {
-            if (chunks == nullptr)
-                chunks = new Chunk<value_type>(N);
-
-            Chunk<value_type> * current_chunk = chunks;
-            while(current_chunk->next != nullptr){
-                current_chunk = current_chunk->next;
-            }
-
-            if (current_chunk->current_chunk_size == N){
-                current_chunk->next = new Chunk<value_type>(N);
-                auto temp = current_chunk;
-                current_chunk = current_chunk->next;
-                current_chunk->prev = temp;
-            }
-            current_chunk->chunk[current_chunk->current_chunk_size] = value;
-            current_chunk->current_chunk_size++;
-            chunk_list_size++;
+            emplace_back(value);
         }
 
         void push_back(T &&value) {
-            if (chunks == nullptr)
-                chunks = new Chunk<value_type>(N);
-
-            Chunk<value_type> * current_chunk = chunks;
-            while(current_chunk->next != nullptr){
-                current_chunk = current_chunk->next;
-            }
-
-            if (current_chunk->current_chunk_size == N){
-                current_chunk->next = new Chunk<value_type>(N);
-                auto temp = current_chunk;
-                current_chunk = current_chunk->next;
-                current_chunk->prev = temp;
-            }
-            current_chunk->chunk[current_chunk->current_chunk_size] = std::move(value);
-            current_chunk->current_chunk_size++;
-            chunk_list_size++;
+            emplace_back(std::move(value));
         }
 
+        //Constructs the element in the first free slot of the last chunk
         template<class... Args>
-        reference emplace_back(Args &&... args){
-            auto data = { std::forward<Args>(args)... };
-            for (auto iter = data.begin(); iter != data.end(); iter++)
-                push_back(*iter);
-            return back();
+        reference emplace_back(Args &&... args) {
+            trace_operation(TraceOperation::push_back, chunk_list_size);
+            Chunk<value_type> *current_chunk = back_chunk_with_room();
+            value_type *element;
+            try {
+                element = construct_slot(current_chunk, current_chunk->current_chunk_size, std::forward<Args>(args)...);
+            } catch (...) {
+                if (current_chunk->current_chunk_size == 0 && current_chunk != chunks)
+                    unlink_chunk(current_chunk);
+                throw;
+            }
+            commit_back(current_chunk);
+            zone_add(current_chunk, *element);
+            trim_ring();
+            publish_bounds();
+            return *element;
         }
 
         void pop_back() {
-            if(chunks == nullptr){
+            if(chunk_list_size == 0){
                 throw std::runtime_error("empty");
                 return;
             }
+            trace_operation(TraceOperation::pop_back, chunk_list_size - 1);
             chunk_list_size--;
-            Chunk<value_type> *current_chunk = chunks;
-
-            while(current_chunk->next != nullptr) {
-                current_chunk = current_chunk->next;
-            }
+            fences_stale = true;
+            Chunk<value_type> *current_chunk = back_chunk(ChunkListOperation::pop);
 
+            drop_handle(current_chunk, current_chunk->current_chunk_size - 1);
+            zone_remove(current_chunk, current_chunk->chunk[current_chunk->current_chunk_size - 1]);
+            std::destroy_at(current_chunk->chunk + current_chunk->current_chunk_size - 1);
             current_chunk->current_chunk_size--;
+            trim_dead_tail(current_chunk);
+            if (current_chunk->current_chunk_size == 0 && current_chunk != chunks) {
+                current_chunk->prev->next = nullptr;
+                last_chunk = current_chunk->prev;
+                release_chunk(current_chunk);
+            }
         }
 
         void push_front(const T &value) {
@@ -926,46 +2627,731 @@ namespace fefu_laboratory_two {
 
         template<class... Args>
         reference emplace_front(Args &&... args) {
-            auto data = {std::forward<Args>(args)...};
-            auto current_element = data.end() - 1;
-
-            while (true) {
-                insert(cbegin(), *current_element);
-                if (current_element == data.begin())
-                    break;
-                current_element--;
-            }
-            return back();
+            return *emplace(cbegin(), std::forward<Args>(args)...);
         }
 
+        //In shared reading mode the element is only marked erased, so that snapshots can go on reading it, and
+        //its chunk is retired once the whole of it has been popped
         void pop_front() {
-            erase(cbegin());
+            if (shared_reads == nullptr) {
+                erase(cbegin());
+                return;
+            }
+            if (chunk_list_size == 0)
+                throw std::out_of_range("Out of bounds");
+            while (chunks->live_size() == 0)
+                unlink_chunk(chunks);
+            Chunk<value_type> *first_chunk = chunks;
+            int position = first_chunk->next_live(0);
+            trace_operation(TraceOperation::erase, 0);
+            forget_finger();
+            drop_handle(first_chunk, position);
+            zone_remove(first_chunk, first_chunk->chunk[position]);
+            first_chunk->dead_slots[position / 64] |= std::uint64_t(1) << (position % 64);
+            first_chunk->dead_count++;
+            chunk_list_size--;
+            fences_stale = true;
+            if (first_chunk->live_size() == 0 && first_chunk->next != nullptr)
+                unlink_chunk(first_chunk);
+            publish_bounds();
         }
 
+        //Works a chunk at a time: growing value-initializes whole runs of slots, and shrinking releases whole
+        //chunks, which for trivially destructible elements costs nothing per element
         void resize(size_type count) {
-            if (chunk_list_size == count)
+            if (chunk_list_size > count)
+                truncate(count);
+            else if (chunk_list_size < count)
+                grow(count, [](T *first, int length) { std::uninitialized_value_construct_n(first, length); });
+        }
+
+        void resize(size_type count, const value_type &value) {
+            if (chunk_list_size > count)
+                truncate(count);
+            else if (chunk_list_size < count)
+                grow(count, [&value](T *first, int length) { std::uninitialized_fill_n(first, length, value); });
+        }
+
+        //The last new element takes value over, the ones before it are copies
+        void resize(size_type count, value_type &&value) {
+            if (chunk_list_size >= count) {
+                truncate(count);
+                return;
+            }
+            if (chunk_list_size + 1 < count)
+                resize(count - 1, static_cast<const value_type &>(value));
+            emplace_back(std::move(value));
+        }
+
+        //Sorts every chunk in place, then merges the sorted chunks into a new chain
+        template<typename Compare = std::less<>>
+        void sort(Compare comp = Compare()) {
+            sort_chunks(comp, [](T *first, T *last, Compare &chunk_comp) { std::sort(first, last, chunk_comp); });
+        }
+
+        template<typename Compare = std::less<>>
+        void stable_sort(Compare comp = Compare()) {
+            sort_chunks(comp, [](T *first, T *last, Compare &chunk_comp) {
+                std::stable_sort(first, last, chunk_comp);
+            });
+        }
+
+        //Merges the sorted other into this sorted list, reusing the chunks of both. Equal elements of this
+        //list go first, and other is left empty
+        template<typename Compare = std::less<>>
+        void merge(ChunkList &&other, Compare comp = Compare()) {
+            if (this == &other || other.chunk_list_size == 0)
+                return;
+            drop_all_handles();
+            other.drop_all_handles();
+            compact();
+            other.compact();
+            std::vector<MergeRun> runs;
+            add_chain_run(runs, *this);
+            add_chain_run(runs, other);
+            int total_size = chunk_list_size + other.chunk_list_size;
+            Chunk<value_type> *other_chunks = other.chunks;
+            other.chunks = nullptr;
+            other.last_chunk_stale = true;
+            other.chunk_list_size = 0;
+            Chunk<value_type> *our_chunks = chunks;
+            chunks = nullptr;
+            chunk_list_size = 0;
+            release_empty_chunks(our_chunks);
+            other.release_empty_chunks(other_chunks);
+            merge_runs(runs, comp, total_size);
+        }
+
+        //Makes erase mark a tombstone in a per-chunk bitmap instead of shifting the chunk. A chunk is
+        //compacted once its share of tombstones exceeds compaction_threshold
+        void enable_lazy_erase(double compaction_threshold = 0.25) {
+            for (Chunk<value_type> *current_chunk = chunks; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                if (current_chunk->dead_slots == nullptr)
+                    current_chunk->dead_slots = new std::uint64_t[Chunk<value_type>::bitmap_words(N)]();
+            }
+            lazy_erase = true;
+            tombstone_threshold = compaction_threshold;
+        }
+
+        void disable_lazy_erase() {
+            if (ring_capacity != 0)
+                throw std::logic_error("Ring mode evicts elements as tombstones");
+            compact();
+            lazy_erase = false;
+            for (Chunk<value_type> *current_chunk = chunks; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                delete[] current_chunk->dead_slots;
+                current_chunk->dead_slots = nullptr;
+            }
+            for (Chunk<value_type> *current_chunk = spare_chunks; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                delete[] current_chunk->dead_slots;
+                current_chunk->dead_slots = nullptr;
+            }
+        }
+
+        bool is_lazy_erase() const noexcept {
+            return lazy_erase;
+        }
+
+        //Squeezes the tombstones out of every chunk
+        void compact() {
+            for (Chunk<value_type> *current_chunk = chunks; current_chunk != nullptr; current_chunk = current_chunk->next)
+                compact_chunk(current_chunk);
+        }
+
+        //Keeps the min, max, sum and count of every chunk, so that the range queries below read whole chunks
+        //from their summary and scan only the two edge chunks. push_back, insert, erase, the pops and set()
+        //update the summary of their chunk in place; bulk changes such as sort, assign, resize or
+        //append_from_fd leave it to be recomputed by the next query which needs it. Writes through references
+        //need refresh_zone_maps()
+        void enable_zone_maps() {
+            static_assert(std::is_arithmetic_v<T>, "Zone maps need arithmetic elements");
+            for (Chunk<value_type> *current_chunk = chunks; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                if (current_chunk->zone == nullptr)
+                    current_chunk->zone = new_zone();
+                current_chunk->zone->stale = true;
+            }
+            zone_maps = true;
+        }
+
+        void disable_zone_maps() noexcept {
+            zone_maps = false;
+            for (Chunk<value_type> *current_chunk = chunks; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                delete current_chunk->zone;
+                current_chunk->zone = nullptr;
+            }
+            for (Chunk<value_type> *current_chunk = spare_chunks; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                delete current_chunk->zone;
+                current_chunk->zone = nullptr;
+            }
+        }
+
+        bool has_zone_maps() const noexcept {
+            return zone_maps;
+        }
+
+        void refresh_zone_maps() noexcept {
+            touch_all_zones();
+        }
+
+        //Overwrites the element at pos and keeps its chunk's summary up to date
+        void set(size_type pos, const value_type &value) {
+            if (pos >= chunk_list_size) throw std::out_of_range("Out of bounds");
+            trace_operation(TraceOperation::access, pos);
+            Chunk<value_type> *current_chunk = locate(pos, ChunkListOperation::access);
+            value_type &element = current_chunk->chunk[pos];
+            if (zone_maps) {
+                zone_remove(current_chunk, element);
+                element = value;
+                zone_add(current_chunk, element);
+            } else {
+                element = value;
+            }
+            fences_stale = true;
+        }
+
+        //Sum of the elements at positions first up to last, not including last
+        sum_type sum(size_type first, size_type last) const {
+            require_zone_maps();
+            sum_type total = sum_type();
+            visit_range(first, last, [this, &total](Chunk<value_type> *current_chunk) {
+                total += zone_of(current_chunk).sum;
+            }, [&total](const value_type *elements, size_type length) {
+                for (size_type i = 0; i < length; i++)
+                    total += elements[i];
+            });
+            return total;
+        }
+
+        //Smallest element at positions first up to last, not including last
+        value_type min(size_type first, size_type last) const {
+            require_zone_maps();
+            if (first >= last)
+                throw std::out_of_range("Empty range");
+            const value_type *smallest = nullptr;
+            visit_range(first, last, [this, &smallest](Chunk<value_type> *current_chunk) {
+                const value_type &candidate = zone_of(current_chunk).min;
+                if (smallest == nullptr || candidate < *smallest)
+                    smallest = &candidate;
+            }, [&smallest](const value_type *elements, size_type length) {
+                const value_type *candidate = std::min_element(elements, elements + length);
+                if (smallest == nullptr || *candidate < *smallest)
+                    smallest = candidate;
+            });
+            return *smallest;
+        }
+
+        //Largest element at positions first up to last, not including last
+        value_type max(size_type first, size_type last) const {
+            require_zone_maps();
+            if (first >= last)
+                throw std::out_of_range("Empty range");
+            const value_type *largest = nullptr;
+            visit_range(first, last, [this, &largest](Chunk<value_type> *current_chunk) {
+                const value_type &candidate = zone_of(current_chunk).max;
+                if (largest == nullptr || *largest < candidate)
+                    largest = &candidate;
+            }, [&largest](const value_type *elements, size_type length) {
+                const value_type *candidate = std::max_element(elements, elements + length);
+                if (largest == nullptr || *largest < *candidate)
+                    largest = candidate;
+            });
+            return *largest;
+        }
+
+        //Number of elements from low to high inclusive. Chunks whose summary lies wholly inside the bounds
+        //are counted without a scan and chunks wholly outside them are skipped
+        size_type count_if_in_range(const value_type &low, const value_type &high) const {
+            require_zone_maps();
+            size_type count = 0;
+            if (high < low)
+                return 0;
+            for (Chunk<value_type> *current_chunk = chunks; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                if (current_chunk->live_size() == 0)
+                    continue;
+                const ChunkZone<value_type> &zone = zone_of(current_chunk);
+                if (high < zone.min || zone.max < low)
+                    continue;
+                if (!(zone.min < low) && !(high < zone.max)) {
+                    count += zone.count;
+                    continue;
+                }
+                for (int position = current_chunk->next_live(0); position < current_chunk->current_chunk_size;) {
+                    int length = current_chunk->live_run(position);
+                    for (const value_type *element = current_chunk->chunk + position,
+                                 *run_end = element + length; element != run_end; ++element)
+                        count += !(*element < low) && !(high < *element) ? 1 : 0;
+                    position = current_chunk->next_live(position + length);
+                }
+            }
+            return count;
+        }
+
+        //Sorts the list if needed and from then on keeps the first and last key of every chunk in a side
+        //array, so that lookups binary-search the chunks instead of scanning. Elements written through
+        //references must keep the order
+        void enable_sorted_mode() {
+            compact();
+            bool is_sorted = true;
+            const value_type *previous = nullptr;
+            for (Chunk<value_type> *current_chunk = chunks; current_chunk != nullptr && is_sorted;
+                 current_chunk = current_chunk->next) {
+                for (int i = 0; i < current_chunk->current_chunk_size; i++) {
+                    if (previous != nullptr && current_chunk->chunk[i] < *previous) {
+                        is_sorted = false;
+                        break;
+                    }
+                    previous = &current_chunk->chunk[i];
+                }
+            }
+            if (!is_sorted)
+                sort();
+            sorted_mode = true;
+            rebuild_fences();
+        }
+
+        void disable_sorted_mode() noexcept {
+            sorted_mode = false;
+            fences_stale = true;
+            fences.clear();
+            fences.shrink_to_fit();
+        }
+
+        bool is_sorted_mode() const noexcept {
+            return sorted_mode;
+        }
+
+        iterator lower_bound(const value_type &value) const {
+            const std::vector<Fence> &current_fences = sorted_fences();
+            auto fence = std::partition_point(current_fences.begin(), current_fences.end(),
+                                              [&value](const Fence &current) { return current.last < value; });
+            if (fence == current_fences.end())
+                return ChunkList_iterator<value_type>();
+            Chunk<value_type> *found_chunk = fence->chunk;
+            value_type *found = std::lower_bound(found_chunk->chunk, found_chunk->chunk + found_chunk->current_chunk_size,
+                                                 value);
+            return iterator_at(found_chunk, static_cast<int>(found - found_chunk->chunk));
+        }
+
+        iterator upper_bound(const value_type &value) const {
+            const std::vector<Fence> &current_fences = sorted_fences();
+            auto fence = std::partition_point(current_fences.begin(), current_fences.end(),
+                                              [&value](const Fence &current) { return !(value < current.last); });
+            if (fence == current_fences.end())
+                return ChunkList_iterator<value_type>();
+            Chunk<value_type> *found_chunk = fence->chunk;
+            value_type *found = std::upper_bound(found_chunk->chunk, found_chunk->chunk + found_chunk->current_chunk_size,
+                                                 value);
+            return iterator_at(found_chunk, static_cast<int>(found - found_chunk->chunk));
+        }
+
+        std::pair<iterator, iterator> equal_range(const value_type &value) const {
+            return {lower_bound(value), upper_bound(value)};
+        }
+
+        bool contains(const value_type &value) const {
+            iterator found = lower_bound(value);
+            return found != end() && !(value < *found);
+        }
+
+        //Inserts value after the elements equal to it. A full target chunk is split in two
+        iterator insert_sorted(const value_type &value) {
+            sorted_fences();
+            if (fences.empty()) {
+                push_back(value);
+                rebuild_fences();
+                return iterator_at(fences.front().chunk, 0);
+            }
+            auto fence = std::partition_point(fences.begin(), fences.end(),
+                                              [&value](const Fence &current) { return !(value < current.last); });
+            std::size_t index = fence == fences.end() ? fences.size() - 1 : fence - fences.begin();
+            Chunk<value_type> *target = fences[index].chunk;
+            forget_finger();
+            compact_chunk(target);
+            int position = static_cast<int>(
+                    std::upper_bound(target->chunk, target->chunk + target->current_chunk_size, value) - target->chunk);
+
+            if (target->current_chunk_size == N) {
+                fences.reserve(fences.size() + 1);
+                int keep = position <= N / 2 ? N / 2 : (N + 1) / 2;
+                Chunk<value_type> *new_chunk = split_chunk(target, keep);
+                fences.insert(fences.begin() + index + 1, Fence{value, value, new_chunk});
+                if (keep != 0)
+                    refresh_fence(index);
+                if (new_chunk->current_chunk_size != 0)
+                    refresh_fence(index + 1);
+                if (position > keep || keep == N) {
+                    target = new_chunk;
+                    position -= keep;
+                    index++;
+                }
+            }
+
+            construct_shifted(target, position, value);
+            chunk_list_size++;
+            refresh_fence(index);
+            return iterator_at(target, position);
+        }
+
+        //Empty buffer of one chunk from the list's allocator, for a producer to fill and pass to adopt_back()
+        buffer_type make_buffer() {
+            return buffer_type(chunk_allocator, chunk_allocator.allocate(N), 0, N);
+        }
+
+        //Unlinks the first chunk and hands its buffer over as it is, or returns an empty buffer when the list
+        //is empty. Tombstones are squeezed out first and handles of the drained elements go stale
+        buffer_type drain_front_chunk() {
+            if (chunk_list_size == 0)
+                return buffer_type();
+            forget_finger();
+            Chunk<value_type> *first_chunk = chunks;
+            compact_chunk(first_chunk);
+            for (int i = 0; i < first_chunk->current_chunk_size; i++)
+                drop_handle(first_chunk, i);
+            buffer_type drained(chunk_allocator, first_chunk->chunk, first_chunk->current_chunk_size, N);
+            chunk_list_size -= first_chunk->current_chunk_size;
+            first_chunk->chunk = nullptr;
+            chunks = first_chunk->next;
+            if (chunks != nullptr)
+                chunks->prev = nullptr;
+            else
+                last_chunk = nullptr;
+            delete first_chunk;
+#ifdef CHUNKLIST_ENABLE_COUNTERS
+            counters.chunk_frees++; //The buffer leaves the list as if the chunk had been freed
+#endif
+            fences_stale = true;
+            return drained;
+        }
+
+        //Links buffer in as the last chunk. Buffers of N elements from an equal allocator are taken over without
+        //copying, any other buffer has its elements moved into the list and is then released
+        void adopt_back(buffer_type buffer) {
+            if (buffer.length == 0)
+                return;
+            if (!buffer.from_allocator || buffer.slots != N || buffer.origin != chunk_allocator) {
+                for (size_type i = 0; i < buffer.length; i++)
+                    push_back(std::move(buffer.buffer[i]));
                 return;
-            else if (chunk_list_size > count){
-                while(chunk_list_size != count)
-                    pop_back();
             }
-            else {
-                while(chunk_list_size != count)
-                    push_back(value_type());
+
+            auto *new_chunk = new Chunk<value_type>();
+            try {
+                if (lazy_erase)
+                    new_chunk->dead_slots = new std::uint64_t[Chunk<value_type>::bitmap_words(N)]();
+                if (handle_mode)
+                    new_chunk->handle_slots = new std::uint32_t[N]();
+                if (zone_maps)
+                    new_chunk->zone = new_zone();
+            } catch (...) {
+                delete new_chunk;
+                throw;
+            }
+            new_chunk->chunk = buffer.buffer;
+            new_chunk->chunk_size = N;
+            new_chunk->current_chunk_size = static_cast<int>(buffer.length);
+            buffer.buffer = nullptr;
+#ifdef CHUNKLIST_ENABLE_COUNTERS
+            counters.chunk_allocations++;
+#endif
+            touch_zone(new_chunk);
+
+            Chunk<value_type> *previous_chunk = back_chunk(ChunkListOperation::push);
+            if (previous_chunk != nullptr && previous_chunk->current_chunk_size == 0) {
+                unlink_chunk(previous_chunk);
+                previous_chunk = last_chunk;
             }
+            new_chunk->prev = previous_chunk;
+            if (previous_chunk == nullptr)
+                chunks = new_chunk;
+            else
+                previous_chunk->next = new_chunk;
+            last_chunk = new_chunk;
+            chunk_list_size += new_chunk->current_chunk_size;
+            fences_stale = true;
+            trim_ring();
+            publish_bounds();
+        }
+
+#ifdef CHUNKLIST_HAS_READV
+        //Elements worth preparing room for before reading fd: the bytes it already holds rounded up to whole
+        //elements, a chunk to wait on when it holds none, or a fixed batch of chunks when it cannot tell
+        size_type readable_elements(int fd) const noexcept {
+            constexpr size_type unknown_batch_chunks = 16;
+            int pending = 0;
+            if (ioctl(fd, FIONREAD, &pending) != 0 || pending < 0)
+                return unknown_batch_chunks * N;
+            if (pending == 0)
+                return N;
+            return (ingest_carry.size() + static_cast<size_type>(pending) + sizeof(T) - 1) / sizeof(T);
+        }
+
+        //Reads up to max_elems elements from fd with one readv() straight into the free slots of the last chunk
+        //and of fresh chunks, and appends the ones that arrived whole. Fresh chunks are allocated only for the
+        //bytes fd reports as ready, so a large max_elems costs nothing extra. The bytes of a trailing partial
+        //element are kept and completed by the next call. Returns the number of elements appended, which is 0
+        //only at the end of the input or when a non-blocking fd has no data. Input ending inside an element throws
+        size_type append_from_fd(int fd, size_type max_elems) {
+            static_assert(std::is_trivially_copyable_v<T>, "append_from_fd needs trivially copyable elements");
+#ifdef IOV_MAX
+            constexpr size_type max_buffers = IOV_MAX;
+#else
+            constexpr size_type max_buffers = 1024;
+#endif
+            if (chunks == nullptr) {
+                chunks = allocate_chunk();
+                last_chunk = chunks;
+                last_chunk_stale = false;
+            }
+            Chunk<value_type> *tail = back_chunk(ChunkListOperation::push);
+            size_type room = N - tail->current_chunk_size;
+            if (max_elems > room + (max_buffers - 1) * N)
+                max_elems = room + (max_buffers - 1) * N;
+            max_elems = std::min(max_elems, readable_elements(fd));
+            if (max_elems == 0)
+                return 0;
+
+            std::vector<Chunk<value_type> *> fresh_chunks;
+            std::vector<iovec> buffers;
+            auto slot = [&](size_type index) {
+                return index < room ? tail->chunk + tail->current_chunk_size + index :
+                       fresh_chunks[(index - room) / N]->chunk + (index - room) % N;
+            };
+            auto release_fresh = [&](size_type first) {
+                for (size_type i = first; i < fresh_chunks.size(); i++)
+                    release_chunk(fresh_chunks[i]);
+                fresh_chunks.resize(first);
+            };
+
+            size_type complete = 0;
+            try {
+                while (room + fresh_chunks.size() * N < max_elems)
+                    fresh_chunks.push_back(allocate_chunk());
+                char *first = reinterpret_cast<char *>(slot(0));
+                if (!ingest_carry.empty())
+                    std::memcpy(first, ingest_carry.data(), ingest_carry.size());
+                size_type first_length = room != 0 ? std::min(room, max_elems) : std::min<size_type>(N, max_elems);
+                buffers.push_back({first + ingest_carry.size(), first_length * sizeof(T) - ingest_carry.size()});
+                for (size_type index = first_length; index < max_elems; index += N) {
+                    size_type length = std::min<size_type>(N, max_elems - index);
+                    buffers.push_back({slot(index), length * sizeof(T)});
+                }
+
+                while (complete == 0) {
+                    ssize_t received = readv(fd, buffers.data(), static_cast<int>(buffers.size()));
+                    if (received < 0 && errno == EINTR)
+                        continue;
+                    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                        break;
+                    if (received < 0)
+                        throw std::system_error(errno, std::generic_category(), "readv");
+                    if (received == 0) {
+                        if (!ingest_carry.empty()) {
+                            ingest_carry.clear();
+                            throw std::runtime_error("Input ends inside an element");
+                        }
+                        break;
+                    }
+                    size_type total = ingest_carry.size() + static_cast<size_type>(received);
+                    complete = total / sizeof(T);
+                    size_type partial = total % sizeof(T);
+                    ingest_carry.clear();
+                    if (partial != 0) {
+                        const char *partial_bytes = reinterpret_cast<const char *>(slot(complete));
+                        ingest_carry.assign(partial_bytes, partial_bytes + partial);
+                    }
+                    //Nothing whole arrived yet: read again behind the bytes already there
+                    if (complete == 0) {
+                        buffers.front().iov_base = first + partial;
+                        buffers.front().iov_len = first_length * sizeof(T) - partial;
+                    }
+                }
+            } catch (...) {
+                release_fresh(0);
+                throw;
+            }
+
+            size_type in_tail = std::min(room, complete);
+            tail->current_chunk_size += static_cast<int>(in_tail);
+            if (in_tail != 0)
+                touch_zone(tail);
+            size_type used_chunks = complete > room ? (complete - room + N - 1) / N : 0;
+            release_fresh(used_chunks);
+            Chunk<value_type> *previous_chunk = tail;
+            for (size_type i = 0; i < used_chunks; i++) {
+                Chunk<value_type> *filled_chunk = fresh_chunks[i];
+                filled_chunk->current_chunk_size = static_cast<int>(std::min<size_type>(N, complete - room - i * N));
+                touch_zone(filled_chunk);
+                filled_chunk->prev = previous_chunk;
+                previous_chunk->next = filled_chunk;
+                previous_chunk = filled_chunk;
+            }
+            last_chunk = previous_chunk;
+            chunk_list_size += static_cast<int>(complete);
+            fences_stale = true;
+            trim_ring();
+            publish_bounds();
+            return complete;
+        }
+#endif
+
+        //Lets reader threads take snapshots while this thread goes on writing. push_back, emplace_back,
+        //append_from_fd, adopt_back, pop_front and clear publish their result as they finish and may run
+        //alongside snapshots; any other change needs every snapshot gone and publish() called before the next
+        //one is taken. Popped elements are marked erased, so lazy erase is turned on. Not with ring mode
+        void enable_shared_reading() {
+            if (ring_capacity != 0)
+                throw std::logic_error("Ring mode reuses chunks shared readers may be reading");
+            if (shared_reads != nullptr)
+                return;
+            enable_lazy_erase(tombstone_threshold);
+            compact();
+            shared_reads = new ChunkListSharedState<value_type>();
+            publish_bounds();
         }
 
-        void resize(size_type count, const value_type &value){
-            if (chunk_list_size == count)
+        //Needs every snapshot gone. Reclaims the retired chunks and leaves lazy erase on
+        void disable_shared_reading() noexcept {
+            if (shared_reads == nullptr)
                 return;
-            else if (chunk_list_size > count){
-                while(chunk_list_size != count)
-                    pop_back();
+            delete shared_reads;
+            shared_reads = nullptr;
+            reclaim_retired(~std::uint64_t(0));
+        }
+
+        bool is_shared_reading() const noexcept {
+            return shared_reads != nullptr;
+        }
+
+        //Publishes changes made while no snapshot was alive. Squeezes out the tombstones first, which
+        //snapshots do not look at
+        void publish() {
+            if (shared_reads == nullptr)
+                throw std::logic_error("Not in shared reading mode");
+            compact();
+            publish_bounds();
+        }
+
+        //Safe from any thread while the writer works, and never makes it wait. Throws when
+        //ChunkListSharedState::max_readers snapshots are alive already
+        snapshot_type snapshot() const {
+            if (shared_reads == nullptr)
+                throw std::logic_error("Not in shared reading mode");
+            ChunkListSharedState<value_type> &state = *shared_reads;
+            snapshot_type view;
+            std::uint64_t epoch = state.epoch.load();
+            for (; view.pin < state.pins.size(); view.pin++) {
+                std::uint64_t free_slot = 0;
+                if (state.pins[view.pin].epoch.compare_exchange_strong(free_slot, epoch))
+                    break;
             }
-            else {
-                while(chunk_list_size != count)
-                    push_back(value);
+            if (view.pin == state.pins.size())
+                throw std::runtime_error("Too many snapshots");
+            view.state = shared_reads;
+            for (;;) {
+                std::uint64_t sequence = state.sequence.load();
+                if ((sequence & 1) != 0)
+                    continue;
+                view.head = state.head.load(std::memory_order_relaxed);
+                view.head_slot = state.head_slot.load(std::memory_order_relaxed);
+                view.tail = state.tail.load(std::memory_order_relaxed);
+                view.tail_count = state.tail_count.load(std::memory_order_relaxed);
+                view.length = state.size.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (state.sequence.load(std::memory_order_relaxed) == sequence)
+                    return view;
+            }
+        }
+
+        //Turns the list into a sliding window over the newest capacity elements. Evicted elements are marked
+        //erased, so lazy erase is turned on, and once the first chunk holds none but evicted ones push_back
+        //reuses it at the back. Memory then stays at capacity / N + 2 chunks at most, with no allocation after
+        //warm-up
+        void enable_ring_mode(size_type capacity) {
+            if (capacity == 0)
+                throw std::invalid_argument("Ring capacity must be positive");
+            if (shared_reads != nullptr)
+                throw std::logic_error("Ring mode reuses chunks shared readers may be reading");
+            enable_lazy_erase(tombstone_threshold);
+            ring_capacity = capacity;
+            trim_ring();
+        }
+
+        void disable_ring_mode() noexcept {
+            ring_capacity = 0;
+        }
+
+        bool is_ring_mode() const noexcept {
+            return ring_capacity != 0;
+        }
+
+        //Tracks every element which has been given a handle through splits, shifts and compaction. Sorting
+        //and merging reorder the whole list and make all handles stale
+        void enable_handles() {
+            for (Chunk<value_type> *current_chunk = chunks; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                if (current_chunk->handle_slots == nullptr)
+                    current_chunk->handle_slots = new std::uint32_t[N]();
+            }
+            handle_mode = true;
+        }
+
+        void disable_handles() noexcept {
+            drop_all_handles();
+            handle_mode = false;
+            handle_table.clear();
+            free_handle = no_handle;
+            for (Chunk<value_type> *current_chunk = chunks; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                delete[] current_chunk->handle_slots;
+                current_chunk->handle_slots = nullptr;
+            }
+            for (Chunk<value_type> *current_chunk = spare_chunks; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                delete[] current_chunk->handle_slots;
+                current_chunk->handle_slots = nullptr;
+            }
+        }
+
+        bool is_handle_mode() const noexcept {
+            return handle_mode;
+        }
+
+        //Handle of the element at pos, the same one for as long as the element lives
+        ChunkListHandle handle(const_iterator pos) {
+            if (!handle_mode)
+                throw std::runtime_error("Not in handle mode");
+            Chunk<value_type> *current_chunk = pos.chunk;
+            if (current_chunk == nullptr)
+                throw std::out_of_range("Out of bounds");
+            std::uint32_t &entry = current_chunk->handle_slots[pos.iterator_position];
+            if (entry == 0) {
+                std::uint32_t index = free_handle;
+                if (index == no_handle) {
+                    handle_table.push_back({nullptr, 0, 1, no_handle});
+                    index = static_cast<std::uint32_t>(handle_table.size() - 1);
+                } else {
+                    free_handle = handle_table[index].next_free;
+                }
+                handle_table[index].chunk = current_chunk;
+                handle_table[index].slot = pos.iterator_position;
+                entry = index + 1;
             }
+            return {entry - 1, handle_table[entry - 1].generation};
+        }
+
+        //Element of a handle, nullptr when it is stale
+        pointer get(ChunkListHandle element_handle) const noexcept {
+            if (element_handle.index >= handle_table.size())
+                return nullptr;
+            const HandleEntry &entry = handle_table[element_handle.index];
+            if (entry.chunk == nullptr || entry.generation != element_handle.generation)
+                return nullptr;
+            return &entry.chunk->chunk[entry.slot];
+        }
+
+        iterator find(ChunkListHandle element_handle) const noexcept {
+            pointer element = get(element_handle);
+            if (element == nullptr)
+                return ChunkList_iterator<value_type>();
+            const HandleEntry &entry = handle_table[element_handle.index];
+            return ChunkList_iterator<value_type>(entry.chunk, entry.slot, element);
         }
 
         void swap(ChunkList &other) {
@@ -977,59 +3363,83 @@ namespace fefu_laboratory_two {
             other.chunk_list_size = this->chunk_list_size;
             this->chunks = temp;
             this->chunk_list_size=temp_size;
-        }
-
-        template<class U, class Alloc>
-        friend bool operator==(const ChunkList<U, N, Alloc> &lhs,
-                               const ChunkList<U, N, Alloc> &rhs) {
-            bool flag = true;
-            if (lhs.chunk_list_size == rhs.chunk_list_size) {
-                for (int i = 0; i < lhs.chunk_list_size; i++) {
-                    if (lhs.at(i) == rhs.at(i)) {
-                        flag = true;
-                    } else {
-                        flag = false;
-                        break;
-                    }
+            std::swap(chunk_allocator, other.chunk_allocator);
+            std::swap(spare_chunks, other.spare_chunks);
+            std::swap(spare_chunks_count, other.spare_chunks_count);
+            std::swap(chunk_pool_limit, other.chunk_pool_limit);
+            std::swap(lazy_erase, other.lazy_erase);
+            std::swap(tombstone_threshold, other.tombstone_threshold);
+            std::swap(sorted_mode, other.sorted_mode);
+            std::swap(fences_stale, other.fences_stale);
+            fences.swap(other.fences);
+            std::swap(handle_mode, other.handle_mode);
+            std::swap(zone_maps, other.zone_maps);
+            handle_table.swap(other.handle_table);
+            std::swap(free_handle, other.free_handle);
+            std::swap(last_chunk, other.last_chunk);
+            std::swap(last_chunk_stale, other.last_chunk_stale);
+            std::swap(ring_capacity, other.ring_capacity);
+            std::swap(finger_chunk, other.finger_chunk);
+            std::swap(finger_base, other.finger_base);
+            ingest_carry.swap(other.ingest_carry);
+            std::swap(shared_reads, other.shared_reads);
+            std::swap(retired_chunks, other.retired_chunks);
+            std::swap(newest_retired, other.newest_retired);
+            std::swap(retired_count, other.retired_count);
+        }
+
+        friend bool operator==(const ChunkList &lhs,
+                               const ChunkList &rhs) {
+            if (lhs.chunk_list_size != rhs.chunk_list_size)
+                return false;
+            return for_each_common_run(lhs, rhs, [](const value_type *left, const value_type *right, int length) {
+                if constexpr (bytewise_comparable) {
+                    return std::memcmp(left, right, length * sizeof(value_type)) == 0;
+                } else {
+                    return std::equal(left, left + length, right);
                 }
-            }
-            return flag;
+            });
         }
 
-        template<class U, class Alloc>
-        friend bool operator!=(const ChunkList<U, N, Alloc> &lhs,
-                               const ChunkList<U, N, Alloc> &rhs) {
+        friend bool operator!=(const ChunkList &lhs,
+                               const ChunkList &rhs) {
             return !operator==(lhs, rhs);
         }
 
-        template<class U, class Alloc>
-        friend bool operator>(const ChunkList<U, N, Alloc> &lhs, const ChunkList<U, N, Alloc> &rhs) {
-            if (lhs.chunk_list_size <= rhs.chunk_list_size)
-                return false;
-            if (lhs.chunk_list_size > rhs.chunk_list_size)
+        friend bool operator<(const ChunkList &lhs, const ChunkList &rhs) {
+            int order = 0; //Sign of the first differing pair
+            for_each_common_run(lhs, rhs, [&order](const value_type *left, const value_type *right, int length) {
+                if constexpr (bytewise_comparable) {
+                    if (std::memcmp(left, right, length * sizeof(value_type)) == 0)
+                        return true;
+                }
+                for (int i = 0; i < length; i++) {
+                    if (left[i] < right[i]) {
+                        order = -1;
+                        return false;
+                    }
+                    if (right[i] < left[i]) {
+                        order = 1;
+                        return false;
+                    }
+                }
                 return true;
-            for (int i = 0; i < lhs.chunk_list_size; i++) {
-                if (rhs.at(i) >= rhs.at(i))
-                    return false;
-            }
-            return true;
+            });
+            return order != 0 ? order < 0 : lhs.chunk_list_size < rhs.chunk_list_size;
         }
 
-        template<class U, class Alloc>
-        friend bool operator<(const ChunkList<U, N, Alloc> &lhs, const ChunkList<U, N, Alloc> &rhs) {
-            return !(operator==(lhs, rhs) || operator>(lhs, rhs));
+        friend bool operator>(const ChunkList &lhs, const ChunkList &rhs) {
+            return operator<(rhs, lhs);
         }
 
-        template<class U, class Alloc>
-        friend bool operator>=(const ChunkList<U, N, Alloc> &lhs,
-                               const ChunkList<U, N, Alloc> &rhs) {
+        friend bool operator>=(const ChunkList &lhs,
+                               const ChunkList &rhs) {
             return !(operator<(lhs, rhs));
         }
 
-        template<class U, class Alloc>
-        friend bool operator<=(const ChunkList<U, N, Alloc> &lhs,
-                               const ChunkList<U, N, Alloc> &rhs) {
-            return !(operator>(lhs, rhs));
+        friend bool operator<=(const ChunkList &lhs,
+                               const ChunkList &rhs) {
+            return !(operator<(rhs, lhs));
         }
 
     };
@@ -1044,4 +3454,7 @@ namespace fefu_laboratory_two {
 
     template<class T, int N, class Alloc, class Pred>
     typename ChunkList<T, N, Alloc>::size_type erase_if(ChunkList<T, N, Alloc> &c, Pred pred);
-}
\ No newline at end of file
+}
+
+//Bit-packed specializations for bool and PackedUint
+#include "PackedChunkList.hpp"
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fefu_laboratory_two {
+    enum class TraceOperation : std::uint8_t {
+        push_back,
+        pop_back,
+        insert, //Includes push_front, which inserts at 0
+        erase, //Includes pop_front
+        access, //at, operator[], front, back
+        clear,
+        count
+    };
+
+    struct TraceRecord {
+        TraceOperation operation = TraceOperation::push_back;
+        std::size_t position = 0; //Index the operation works on, 0 when it has none
+        std::size_t size = 0; //Size of the list before the operation
+    };
+
+    //Operations of one ChunkList in the order they happened, kept as one operation byte followed by the
+    //position and the size as LEB128 varints, so that a long trace stays a few bytes per operation.
+    //The list records only when built with CHUNKLIST_ENABLE_TRACE and given a recorder
+    class ChunkListTraceRecorder {
+        static constexpr char magic[8] = {'C', 'L', 'T', 'R', 'A', 'C', 'E', '1'};
+
+        std::vector<std::uint8_t> bytes;
+        std::size_t record_count = 0;
+        std::size_t element_bytes = 0; //sizeof the element type of the recorded list
+        bool is_truncated = false;
+
+        void put_varint(std::size_t value) {
+            while (value >= 0x80) {
+                bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            bytes.push_back(static_cast<std::uint8_t>(value));
+        }
+
+        static std::size_t get_varint(const std::vector<std::uint8_t> &data, std::size_t &offset) {
+            std::size_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (offset == data.size())
+                    throw std::runtime_error("Truncated trace");
+                std::uint8_t byte = data[offset++];
+                value |= static_cast<std::size_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0)
+                    return value;
+            }
+            throw std::runtime_error("Corrupt trace");
+        }
+
+    public:
+        //Runs inside noexcept list operations, so running out of memory stops the recording instead of
+        //throwing. What was recorded before stays a consistent prefix
+        void record(TraceOperation operation, std::size_t position, std::size_t size, std::size_t element_size) noexcept {
+            if (is_truncated)
+                return;
+            std::size_t old_bytes = bytes.size();
+            try {
+                bytes.push_back(static_cast<std::uint8_t>(operation));
+                put_varint(position);
+                put_varint(size);
+            } catch (const std::bad_alloc &) {
+                bytes.resize(old_bytes);
+                is_truncated = true;
+                return;
+            }
+            element_bytes = element_size;
+            record_count++;
+        }
+
+        bool truncated() const noexcept {
+            return is_truncated;
+        }
+
+        std::size_t size() const noexcept {
+            return record_count;
+        }
+
+        std::size_t element_size() const noexcept {
+            return element_bytes;
+        }
+
+        //Bytes the encoded records take, without the file header
+        std::size_t encoded_bytes() const noexcept {
+            return bytes.size();
+        }
+
+        void clear() noexcept {
+            bytes.clear();
+            record_count = 0;
+            is_truncated = false;
+        }
+
+        std::vector<TraceRecord> records() const {
+            std::vector<TraceRecord> result;
+            result.reserve(record_count);
+            std::size_t offset = 0;
+            while (offset < bytes.size()) {
+                TraceRecord current;
+                if (bytes[offset] >= static_cast<std::uint8_t>(TraceOperation::count))
+                    throw std::runtime_error("Corrupt trace");
+                current.operation = static_cast<TraceOperation>(bytes[offset++]);
+                current.position = get_varint(bytes, offset);
+                current.size = get_varint(bytes, offset);
+                result.push_back(current);
+            }
+            return result;
+        }
+
+        //File layout: the magic, the element size and the record count as varints, then the records
+        void save(const std::string &path) const {
+            std::vector<std::uint8_t> header(magic, magic + sizeof(magic));
+            ChunkListTraceRecorder counts;
+            counts.put_varint(element_bytes);
+            counts.put_varint(record_count);
+            header.insert(header.end(), counts.bytes.begin(), counts.bytes.end());
+
+            std::ofstream file(path, std::ios::binary);
+            file.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+            file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            if (!file)
+                throw std::runtime_error("Cannot write trace " + path);
+        }
+
+        static ChunkListTraceRecorder load(const std::string &path) {
+            std::ifstream file(path, std::ios::binary);
+            std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            if (!file.eof() && !file)
+                throw std::runtime_error("Cannot read trace " + path);
+            if (data.size() < sizeof(magic) || !std::equal(magic, magic + sizeof(magic), data.begin()))
+                throw std::runtime_error("Not a ChunkList trace: " + path);
+
+            ChunkListTraceRecorder loaded;
+            std::size_t offset = sizeof(magic);
+            loaded.element_bytes = get_varint(data, offset);
+            loaded.record_count = get_varint(data, offset);
+            loaded.bytes.assign(data.begin() + static_cast<std::ptrdiff_t>(offset), data.end());
+            if (loaded.records().size() != loaded.record_count)
+                throw std::runtime_error("Truncated trace " + path);
+            return loaded;
+        }
+    };
+}
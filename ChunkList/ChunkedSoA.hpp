@@ -0,0 +1,278 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "ChunkList.hpp"
+
+namespace fefu_laboratory_two {
+    //Storage of N rows: one contiguous column per field
+    template<int N, typename... Fields>
+    using SoABlock = std::tuple<std::array<Fields, N>...>;
+
+    template<typename Field>
+    struct ChunkedSoA_column_segment {
+        Field *data = nullptr;
+        std::size_t length = 0;
+
+        Field *begin() const noexcept {
+            return data;
+        }
+
+        Field *end() const noexcept {
+            return data + length;
+        }
+
+        std::size_t size() const noexcept {
+            return length;
+        }
+    };
+
+    //Proxy for one row, reading and writing the fields in their columns
+    template<int N, typename... Fields>
+    class ChunkedSoA_row_reference {
+        SoABlock<N, Fields...> *block = nullptr;
+        int slot = 0;
+
+        template<std::size_t... I>
+        std::tuple<Fields...> load(std::index_sequence<I...>) const {
+            return std::tuple<Fields...>(std::get<I>(*block)[slot]...);
+        }
+
+        template<std::size_t... I>
+        void store(const std::tuple<Fields...> &row, std::index_sequence<I...>) {
+            ((std::get<I>(*block)[slot] = std::get<I>(row)), ...);
+        }
+
+    public:
+        ChunkedSoA_row_reference(SoABlock<N, Fields...> *row_block, int row_slot) : block(row_block), slot(row_slot) {}
+
+        template<std::size_t I>
+        auto &get() const {
+            return std::get<I>(*block)[slot];
+        }
+
+        operator std::tuple<Fields...>() const {
+            return load(std::index_sequence_for<Fields...>());
+        }
+
+        ChunkedSoA_row_reference &operator=(const std::tuple<Fields...> &row) {
+            store(row, std::index_sequence_for<Fields...>());
+            return *this;
+        }
+    };
+
+    //Walks one column as a sequence of contiguous segments, one per chunk. A read-only view hands out
+    //segments of const fields
+    template<std::size_t I, int N, bool IsConst, typename... Fields>
+    class ChunkedSoA_column_view {
+        using block_type = SoABlock<N, Fields...>;
+        using field_type = std::conditional_t<IsConst, const std::tuple_element_t<I, std::tuple<Fields...>>,
+                std::tuple_element_t<I, std::tuple<Fields...>>>;
+
+        Chunk<block_type> *first = nullptr;
+        std::size_t rows = 0;
+
+    public:
+        class iterator {
+            Chunk<block_type> *chunk = nullptr;
+            std::size_t remaining = 0; //Rows from this chunk to the end
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = ChunkedSoA_column_segment<field_type>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = value_type;
+
+            iterator() noexcept = default;
+
+            iterator(Chunk<block_type> *current_chunk, std::size_t rows_left) : chunk(current_chunk),
+                                                                                remaining(rows_left) {}
+
+            value_type operator*() const {
+                return {std::get<I>(chunk->chunk[0]).data(), remaining < N ? remaining : static_cast<std::size_t>(N)};
+            }
+
+            iterator &operator++() {
+                remaining = remaining < N ? 0 : remaining - N;
+                chunk = remaining == 0 ? nullptr : chunk->next;
+                return *this;
+            }
+
+            iterator operator++(int) {
+                iterator temp(*this);
+                ++*this;
+                return temp;
+            }
+
+            friend bool operator==(const iterator &left, const iterator &right) {
+                return left.chunk == right.chunk && left.remaining == right.remaining;
+            }
+
+            friend bool operator!=(const iterator &left, const iterator &right) {
+                return !(left == right);
+            }
+        };
+
+        ChunkedSoA_column_view(Chunk<block_type> *first_chunk, std::size_t row_count) : first(first_chunk),
+                                                                                      rows(row_count) {}
+
+        iterator begin() const {
+            return rows == 0 ? iterator() : iterator(first, rows);
+        }
+
+        iterator end() const {
+            return iterator();
+        }
+    };
+
+    //Structure-of-arrays sibling of ChunkList: a chain of chunks where each chunk keeps N rows as one
+    //column per field, so that scanning a field reads only that field's bytes. Rows are appended at the
+    //back, and every chunk except the last is full
+    template<int N, typename... Fields>
+    class ChunkedSoA : protected ChunkList<SoABlock<N, Fields...>, 1> {
+        static_assert(sizeof...(Fields) > 0, "ChunkedSoA needs at least one field");
+        static_assert((std::is_trivially_copyable_v<Fields> && ...), "ChunkedSoA fields must be trivially copyable");
+
+        using block_type = SoABlock<N, Fields...>;
+        using base = ChunkList<block_type, 1>;
+
+        std::size_t rows = 0;
+        Chunk<block_type> *tail_chunk = nullptr;
+
+        void find_tail() noexcept {
+            tail_chunk = this->chunks;
+            while (tail_chunk != nullptr && tail_chunk->next != nullptr)
+                tail_chunk = tail_chunk->next;
+        }
+
+        template<std::size_t... I>
+        void store(block_type &block, int slot, const std::tuple<const Fields &...> &row, std::index_sequence<I...>) {
+            ((std::get<I>(block)[slot] = std::get<I>(row)), ...);
+        }
+
+    public:
+        using size_type = std::size_t;
+        using row_type = std::tuple<Fields...>;
+        using reference = ChunkedSoA_row_reference<N, Fields...>;
+        template<std::size_t I>
+        using column_view = ChunkedSoA_column_view<I, N, false, Fields...>;
+        template<std::size_t I>
+        using const_column_view = ChunkedSoA_column_view<I, N, true, Fields...>;
+
+        ChunkedSoA() {
+            find_tail();
+        }
+
+        ChunkedSoA(const ChunkedSoA &other) : base(other), rows(other.rows) {
+            find_tail();
+        }
+
+        ChunkedSoA(ChunkedSoA &&other) noexcept : base(std::move(other)), rows(other.rows) {
+            other.rows = 0;
+            other.tail_chunk = nullptr;
+            find_tail();
+        }
+
+        ChunkedSoA &operator=(ChunkedSoA other) {
+            swap(other);
+            return *this;
+        }
+
+        ~ChunkedSoA() = default;
+
+        void swap(ChunkedSoA &other) {
+            base::swap(other);
+            std::swap(rows, other.rows);
+            std::swap(tail_chunk, other.tail_chunk);
+        }
+
+        size_type size() const noexcept {
+            return rows;
+        }
+
+        bool empty() const noexcept {
+            return rows == 0;
+        }
+
+        void push_back(const Fields &... values) {
+            int slot = static_cast<int>(rows % N);
+            if (slot == 0) {
+                Chunk<block_type> *new_tail = this->back_chunk_with_room();
+                base::construct_slot(new_tail, 0);
+                this->commit_back(new_tail);
+                tail_chunk = new_tail;
+            }
+            store(tail_chunk->chunk[0], slot, std::tuple<const Fields &...>(values...),
+                  std::index_sequence_for<Fields...>());
+            rows++;
+        }
+
+        void push_back(const row_type &row) {
+            std::apply([this](const Fields &... values) { push_back(values...); }, row);
+        }
+
+        void pop_back() {
+            if (rows == 0)
+                throw std::runtime_error("Empty");
+            rows--;
+            if (rows % N == 0) {
+                Chunk<block_type> *previous_chunk = tail_chunk->prev;
+                bool is_head = tail_chunk == this->chunks;
+                base::pop_back();
+                if (!is_head)
+                    tail_chunk = previous_chunk;
+            }
+        }
+
+        void clear() noexcept {
+            base::clear();
+            rows = 0;
+            tail_chunk = nullptr;
+        }
+
+        reference operator[](size_type pos) {
+            return reference(&base::operator[](pos / N), static_cast<int>(pos % N));
+        }
+
+        reference at(size_type pos) {
+            if (pos >= rows) throw std::out_of_range("Out of bounds");
+            return operator[](pos);
+        }
+
+        row_type at(size_type pos) const {
+            if (pos >= rows) throw std::out_of_range("Out of bounds");
+            return reference(const_cast<block_type *>(&base::at(pos / N)), static_cast<int>(pos % N));
+        }
+
+        template<std::size_t I>
+        column_view<I> column() {
+            return column_view<I>(this->chunks, rows);
+        }
+
+        template<std::size_t I>
+        const_column_view<I> column() const {
+            return const_column_view<I>(this->chunks, rows);
+        }
+
+        //Statistics in rows: the base list counts whole blocks, so fill and bytes are recounted per row
+        ChunkListStats stats() const noexcept {
+            constexpr std::size_t row_bytes = (sizeof(Fields) + ...);
+            ChunkListStats result = base::stats();
+            result.fill_histogram = {};
+            std::size_t rows_left = rows;
+            for (Chunk<block_type> *current_chunk = this->chunks; current_chunk != nullptr; current_chunk = current_chunk->next) {
+                std::size_t chunk_rows = rows_left < N ? rows_left : static_cast<std::size_t>(N);
+                result.fill_histogram[chunk_rows * 10 / N]++;
+                rows_left -= chunk_rows;
+            }
+            result.live_bytes = rows * row_bytes;
+            result.slack_bytes = result.chunk_count * N * row_bytes - result.live_bytes;
+            return result;
+        }
+    };
+}
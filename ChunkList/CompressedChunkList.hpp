@@ -0,0 +1,402 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ChunkList.hpp"
+
+namespace fefu_laboratory_two {
+    enum class ChunkEncoding : std::uint8_t {
+        frame_of_reference, //Offsets of the values from the smallest one
+        delta //Differences of neighbouring values as offsets from the smallest difference
+    };
+
+    //One encoded chunk: its offsets bit-packed at width bits each
+    struct PackedChunk {
+        ChunkEncoding encoding = ChunkEncoding::frame_of_reference;
+        int width = 0;
+        std::uint64_t first = 0; //First value, delta only
+        std::uint64_t base = 0; //Smallest value or difference
+        std::vector<std::uint64_t> bits;
+
+        std::size_t memory() const noexcept {
+            return sizeof(PackedChunk) + bits.size() * sizeof(std::uint64_t);
+        }
+    };
+
+    //ChunkList of integers which keeps its cold full chunks compressed. The hot_chunks most recently
+    //filled or accessed full chunks stay plain, the others are packed with frame-of-reference or delta
+    //encoding, whichever is smaller, and are decoded on access into a cache of cache_chunks chunks.
+    //Elements are read by value and written with set(). Reads stamp chunks and fill the decode cache, so
+    //even reads through a const reference must not run concurrently
+    template<typename T, int N>
+    class CompressedChunkList : protected ChunkList<T, N> {
+        static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "CompressedChunkList holds integers");
+        static_assert(sizeof(T) <= sizeof(std::uint64_t), "CompressedChunkList holds at most 64-bit integers");
+
+        using base = ChunkList<T, N>;
+
+        static constexpr std::size_t no_frame = ~std::size_t(0);
+
+        struct CacheSlot {
+            std::size_t frame = no_frame;
+            std::vector<T> values;
+            bool dirty = false; //Written by set(), encoded again on eviction
+            std::size_t last_use = 0;
+        };
+
+        //One full chunk of the list, either still linked into the plain chain or encoded
+        struct Block {
+            Chunk<T> *plain = nullptr; //nullptr once the chunk is encoded
+            mutable PackedChunk packed; //Encoded again when a written cache slot is evicted by a read
+            mutable std::size_t last_access = 0;
+        };
+
+        std::vector<Block> blocks; //Every full chunk in order. The chain holds the plain ones and the tail
+        std::vector<std::size_t> plain_blocks; //Indices of the plain blocks, freeze candidates
+        std::size_t hot_chunks = 4;
+        mutable std::vector<CacheSlot> cache;
+        mutable std::size_t clock = 0;
+        mutable std::size_t decodes = 0;
+        mutable std::vector<std::uint64_t> offsets; //Scratch space of encode()
+
+        //Maps values to unsigned keys of the same order, so that offsets never go negative
+        static std::uint64_t to_key(T value) noexcept {
+            if constexpr (std::is_signed_v<T>)
+                return static_cast<std::uint64_t>(static_cast<std::int64_t>(value)) ^ (std::uint64_t(1) << 63);
+            else
+                return static_cast<std::uint64_t>(value);
+        }
+
+        static T from_key(std::uint64_t key) noexcept {
+            if constexpr (std::is_signed_v<T>)
+                return static_cast<T>(static_cast<std::int64_t>(key ^ (std::uint64_t(1) << 63)));
+            else
+                return static_cast<T>(key);
+        }
+
+        static int bit_width(std::uint64_t value) noexcept {
+            return value == 0 ? 0 : Chunk<T>::highest_bit(value) + 1;
+        }
+
+        static void pack(std::vector<std::uint64_t> &bits, int width, const std::uint64_t *values, int count) {
+            bits.assign((static_cast<std::size_t>(count) * width + 63) / 64, 0);
+            if (width == 0)
+                return;
+            for (int i = 0; i < count; i++) {
+                std::size_t bit = static_cast<std::size_t>(i) * width;
+                bits[bit / 64] |= values[i] << (bit % 64);
+                if (bit % 64 + width > 64)
+                    bits[bit / 64 + 1] |= values[i] >> (64 - bit % 64);
+            }
+        }
+
+        static std::uint64_t unpack(const std::vector<std::uint64_t> &bits, int width, int index) noexcept {
+            if (width == 0)
+                return 0;
+            std::size_t bit = static_cast<std::size_t>(index) * width;
+            std::uint64_t value = bits[bit / 64] >> (bit % 64);
+            if (bit % 64 + width > 64)
+                value |= bits[bit / 64 + 1] << (64 - bit % 64);
+            return width == 64 ? value : value & ((std::uint64_t(1) << width) - 1);
+        }
+
+        void encode(const T *values, PackedChunk &packed) const {
+            offsets.resize(N);
+            std::uint64_t smallest = to_key(values[0]);
+            std::uint64_t largest = smallest;
+            std::int64_t smallest_step = 0;
+            std::int64_t largest_step = 0;
+            for (int i = 1; i < N; i++) {
+                std::uint64_t key = to_key(values[i]);
+                auto step = static_cast<std::int64_t>(key - to_key(values[i - 1]));
+                smallest = std::min(smallest, key);
+                largest = std::max(largest, key);
+                smallest_step = i == 1 ? step : std::min(smallest_step, step);
+                largest_step = i == 1 ? step : std::max(largest_step, step);
+            }
+            int reference_width = bit_width(largest - smallest);
+            int delta_width = bit_width(static_cast<std::uint64_t>(largest_step) - static_cast<std::uint64_t>(smallest_step));
+
+            if (static_cast<std::size_t>(delta_width) * (N - 1) < static_cast<std::size_t>(reference_width) * N) {
+                packed.encoding = ChunkEncoding::delta;
+                packed.width = delta_width;
+                packed.first = to_key(values[0]);
+                packed.base = static_cast<std::uint64_t>(smallest_step);
+                for (int i = 1; i < N; i++)
+                    offsets[i - 1] = to_key(values[i]) - to_key(values[i - 1]) - packed.base;
+                pack(packed.bits, delta_width, offsets.data(), N - 1);
+            } else {
+                packed.encoding = ChunkEncoding::frame_of_reference;
+                packed.width = reference_width;
+                packed.first = 0;
+                packed.base = smallest;
+                for (int i = 0; i < N; i++)
+                    offsets[i] = to_key(values[i]) - smallest;
+                pack(packed.bits, reference_width, offsets.data(), N);
+            }
+        }
+
+        static void decode(const PackedChunk &packed, T *values) noexcept {
+            if (packed.encoding == ChunkEncoding::delta) {
+                std::uint64_t key = packed.first;
+                values[0] = from_key(key);
+                for (int i = 1; i < N; i++) {
+                    key += packed.base + unpack(packed.bits, packed.width, i - 1);
+                    values[i] = from_key(key);
+                }
+            } else {
+                for (int i = 0; i < N; i++)
+                    values[i] = from_key(packed.base + unpack(packed.bits, packed.width, i));
+            }
+        }
+
+        //Cache slot holding frame, decoding it into the least recently used slot when it is not cached
+        CacheSlot &cached(std::size_t frame) const {
+            CacheSlot *victim = &cache.front();
+            for (CacheSlot &slot : cache) {
+                if (slot.frame == frame) {
+                    slot.last_use = ++clock;
+                    return slot;
+                }
+                if (slot.last_use < victim->last_use)
+                    victim = &slot;
+            }
+            evict(*victim);
+            decode(blocks[frame].packed, victim->values.data());
+            victim->frame = frame;
+            victim->last_use = ++clock;
+            decodes++;
+            return *victim;
+        }
+
+        void evict(CacheSlot &slot) const {
+            if (slot.dirty)
+                encode(slot.values.data(), blocks[slot.frame].packed);
+            slot.frame = no_frame;
+            slot.dirty = false;
+        }
+
+        //Number of elements past the last full chunk, all in the last chunk of the chain
+        std::size_t tail_size() const noexcept {
+            return base::size() - plain_blocks.size() * N;
+        }
+
+        Chunk<T> *tail_chunk() const noexcept {
+            return this->back_chunk(ChunkListOperation::access);
+        }
+
+        //Encodes the least recently accessed plain chunks until at most hot_chunks full ones are left
+        void freeze_cold_chunks() {
+            while (plain_blocks.size() > hot_chunks) {
+                auto coldest = std::min_element(plain_blocks.begin(), plain_blocks.end(),
+                                                [this](std::size_t left, std::size_t right) {
+                                                    return blocks[left].last_access < blocks[right].last_access;
+                                                });
+                Block &block = blocks[*coldest];
+                encode(block.plain->chunk, block.packed);
+                this->chunk_list_size -= N;
+                this->unlink_chunk(block.plain);
+                block.plain = nullptr;
+                plain_blocks.erase(coldest);
+            }
+        }
+
+        //Decodes the last block, which is encoded, back onto the end of the plain chain
+        void thaw_last_block() {
+            CacheSlot &slot = cached(blocks.size() - 1);
+            Chunk<T> *plain_chunk = this->back_chunk_with_room();
+            std::copy(slot.values.begin(), slot.values.end(), plain_chunk->chunk);
+            plain_chunk->current_chunk_size = N;
+            this->chunk_list_size += N;
+            this->fences_stale = true;
+            slot.frame = no_frame;
+            slot.dirty = false;
+        }
+
+        //Block of pos, stamped as accessed
+        const Block &touch(std::size_t pos) const noexcept {
+            const Block &block = blocks[pos / N];
+            block.last_access = ++clock;
+            return block;
+        }
+
+        std::size_t frozen_count() const noexcept {
+            return blocks.size() - plain_blocks.size();
+        }
+
+        //Points the plain blocks at the chunks of this list's chain, which holds them in order
+        void relink_plain_blocks() noexcept {
+            Chunk<T> *current_chunk = this->chunks;
+            for (std::size_t index : plain_blocks) {
+                blocks[index].plain = current_chunk;
+                current_chunk = current_chunk->next;
+            }
+        }
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+
+        explicit CompressedChunkList(size_type hot_chunk_count = 4, size_type cache_chunks = 4) :
+                hot_chunks(hot_chunk_count), cache(cache_chunks == 0 ? 1 : cache_chunks) {
+            for (CacheSlot &slot : cache)
+                slot.values.resize(N);
+        }
+
+        CompressedChunkList(const CompressedChunkList &other) :
+                base(other), blocks(other.blocks), plain_blocks(other.plain_blocks), hot_chunks(other.hot_chunks),
+                cache(other.cache), clock(other.clock), decodes(other.decodes) {
+            relink_plain_blocks();
+        }
+
+        CompressedChunkList(CompressedChunkList &&other) = default;
+
+        CompressedChunkList &operator=(const CompressedChunkList &other) {
+            if (this == &other)
+                return *this;
+            base::operator=(other);
+            blocks = other.blocks;
+            plain_blocks = other.plain_blocks;
+            hot_chunks = other.hot_chunks;
+            cache = other.cache;
+            clock = other.clock;
+            decodes = other.decodes;
+            relink_plain_blocks();
+            return *this;
+        }
+
+        CompressedChunkList &operator=(CompressedChunkList &&other) = default;
+
+        size_type size() const noexcept {
+            return frozen_count() * N + base::size();
+        }
+
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        void push_back(const T &value) {
+            base::push_back(value);
+            if (tail_size() == N) {
+                blocks.push_back(Block{tail_chunk(), PackedChunk(), ++clock});
+                plain_blocks.push_back(blocks.size() - 1);
+                freeze_cold_chunks();
+            }
+        }
+
+        void pop_back() {
+            if (empty())
+                throw std::runtime_error("Empty");
+            if (tail_size() == 0) {
+                if (blocks.back().plain == nullptr)
+                    thaw_last_block();
+                else
+                    plain_blocks.erase(std::find(plain_blocks.begin(), plain_blocks.end(), blocks.size() - 1));
+                blocks.pop_back();
+            }
+            base::pop_back();
+        }
+
+        void clear() noexcept {
+            base::clear();
+            blocks.clear();
+            plain_blocks.clear();
+            for (CacheSlot &slot : cache) {
+                slot.frame = no_frame;
+                slot.dirty = false;
+            }
+        }
+
+        //Encoded elements cost a chunk decode unless their chunk is in the cache. Reading a full chunk
+        //counts as an access which keeps it from being frozen
+        T operator[](size_type pos) const {
+            if (pos >= blocks.size() * N)
+                return tail_chunk()->chunk[pos % N];
+            const Block &block = touch(pos);
+            if (block.plain != nullptr)
+                return block.plain->chunk[pos % N];
+            return cached(pos / N).values[pos % N];
+        }
+
+        T at(size_type pos) const {
+            if (pos >= size()) throw std::out_of_range("Out of bounds");
+            return operator[](pos);
+        }
+
+        T front() const {
+            if (empty()) throw std::runtime_error("Empty");
+            return operator[](0);
+        }
+
+        T back() const {
+            if (empty()) throw std::runtime_error("Empty");
+            return operator[](size() - 1);
+        }
+
+        void set(size_type pos, const T &value) {
+            if (pos >= size()) throw std::out_of_range("Out of bounds");
+            if (pos >= blocks.size() * N) {
+                tail_chunk()->chunk[pos % N] = value;
+                return;
+            }
+            const Block &block = touch(pos);
+            if (block.plain != nullptr) {
+                block.plain->chunk[pos % N] = value;
+                return;
+            }
+            CacheSlot &slot = cached(pos / N);
+            slot.values[pos % N] = value;
+            slot.dirty = true;
+        }
+
+        //Passes every element in order to visit. Encoded chunks are decoded into a scratch buffer, and
+        //the scan neither touches the cache nor counts as an access
+        template<typename Visitor>
+        void for_each(Visitor visit) const {
+            std::vector<T> scratch(N);
+            for (size_type frame = 0; frame < blocks.size(); frame++) {
+                const T *values = scratch.data();
+                auto slot = std::find_if(cache.begin(), cache.end(),
+                                         [frame](const CacheSlot &current) { return current.frame == frame; });
+                if (blocks[frame].plain != nullptr)
+                    values = blocks[frame].plain->chunk;
+                else if (slot != cache.end())
+                    values = slot->values.data();
+                else
+                    decode(blocks[frame].packed, scratch.data());
+                for (int i = 0; i < N; i++)
+                    visit(values[i]);
+            }
+            for (size_type i = 0; i < tail_size(); i++)
+                visit(tail_chunk()->chunk[i]);
+        }
+
+        //Number of most recently filled or accessed full chunks kept plain. Lowering it encodes the least
+        //recently accessed ones above the new limit
+        void set_hot_chunks(size_type count) {
+            hot_chunks = count;
+            freeze_cold_chunks();
+        }
+
+        ChunkListStats stats() const {
+            ChunkListStats result = base::stats();
+            result.chunk_count += frozen_count();
+            result.fill_histogram[ChunkListStats::fill_buckets - 1] += frozen_count();
+            result.live_bytes = size() * sizeof(T);
+            result.compressed_chunks = frozen_count();
+            for (const Block &block : blocks) {
+                if (block.plain == nullptr)
+                    result.compressed_bytes += block.packed.memory();
+            }
+            result.compressed_raw_bytes = frozen_count() * N * sizeof(T);
+            result.chunk_decodes = decodes;
+            return result;
+        }
+    };
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <new>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define CHUNKLIST_HAS_MMAP 1
+#endif
+
+namespace fefu_laboratory_two {
+    struct HugePageStats {
+        std::size_t regions = 0;
+        std::size_t huge_page_regions = 0; //Regions advised for transparent huge pages while they are not turned off
+        std::size_t reserved_bytes = 0; //Bytes mapped for all regions
+        std::size_t bytes_in_use = 0; //Bytes of blocks handed out and not returned, rounded up to pages
+    };
+
+    //Page-aligned blocks carved out of 2 MB aligned regions. Returned blocks are kept in per-size free lists,
+    //and a request with no block of its size splits the smallest larger free one. The shared regions are
+    //unmapped only when the arena goes away. Blocks larger than a region get a region of their own, which is
+    //unmapped as soon as the block is returned
+    class HugePageArena {
+    public:
+        static constexpr std::size_t region_size = std::size_t(2) << 20;
+        static constexpr std::size_t page_size = 4096;
+
+        HugePageArena() = default;
+
+        HugePageArena(const HugePageArena &) = delete;
+
+        HugePageArena &operator=(const HugePageArena &) = delete;
+
+        ~HugePageArena() {
+            for (const Region &region : regions)
+                unmap(region.address, region.size);
+        }
+
+        void *allocate(std::size_t bytes) {
+            std::size_t size = round_up(bytes == 0 ? 1 : bytes, page_size);
+            if (size > region_size) {
+                char *block = map_region(round_up(size, region_size));
+                usage.bytes_in_use += size;
+                return block;
+            }
+
+            void *&free_head = free_blocks[size]; //Created here, so that deallocate() never allocates
+            if (free_head != nullptr) {
+                void *block = free_head;
+                free_head = *static_cast<void **>(block);
+                usage.bytes_in_use += size;
+                return block;
+            }
+
+            char *block = split_free_block(size);
+            if (block == nullptr) {
+                if (cursor == nullptr || cursor_left < size) {
+                    char *fresh_region = map_region(region_size);
+                    if (cursor_left != 0)
+                        push_free(cursor, cursor_left); //The tail of the old region serves smaller requests
+                    cursor = fresh_region;
+                    cursor_left = region_size;
+                }
+                block = cursor;
+                cursor += size;
+                cursor_left -= size;
+            }
+            usage.bytes_in_use += size;
+            return block;
+        }
+
+        void deallocate(void *block, std::size_t bytes) noexcept {
+            std::size_t size = round_up(bytes == 0 ? 1 : bytes, page_size);
+            usage.bytes_in_use -= size;
+            if (size > region_size) {
+                release_region(static_cast<char *>(block));
+                return;
+            }
+
+            void *&free_head = free_blocks.find(size)->second;
+            *static_cast<void **>(block) = free_head;
+            free_head = block;
+        }
+
+        const HugePageStats &stats() const noexcept {
+            return usage;
+        }
+
+    private:
+        struct Region {
+            char *address;
+            std::size_t size;
+            bool huge;
+        };
+
+        std::vector<Region> regions;
+        std::map<std::size_t, void *> free_blocks; //Block size -> head of the list threaded through the blocks
+        char *cursor = nullptr; //Unused tail of the newest region
+        std::size_t cursor_left = 0;
+        HugePageStats usage;
+
+        void push_free(char *block, std::size_t size) {
+            void *&free_head = free_blocks[size];
+            *reinterpret_cast<void **>(block) = free_head;
+            free_head = block;
+        }
+
+        //Front size bytes of the smallest free block larger than size, whose rest goes back to the free
+        //lists, or nullptr when there is none
+        char *split_free_block(std::size_t size) {
+            for (auto larger = free_blocks.upper_bound(size); larger != free_blocks.end(); ++larger) {
+                if (larger->second == nullptr)
+                    continue;
+                void *&rest_head = free_blocks[larger->first - size]; //Inserted before anything is taken
+                auto *block = static_cast<char *>(larger->second);
+                larger->second = *static_cast<void **>(larger->second);
+                *reinterpret_cast<void **>(block + size) = rest_head;
+                rest_head = block + size;
+                return block;
+            }
+            return nullptr;
+        }
+
+        //madvise(MADV_HUGEPAGE) succeeds even when transparent huge pages are turned off system-wide
+        static bool huge_pages_enabled() noexcept {
+            static const bool enabled = [] {
+                std::FILE *settings = std::fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+                if (settings == nullptr)
+                    return false;
+                char line[128] = {};
+                bool readable = std::fgets(line, sizeof(line), settings) != nullptr;
+                std::fclose(settings);
+                return readable && std::strstr(line, "[never]") == nullptr;
+            }();
+            return enabled;
+        }
+
+        static std::size_t round_up(std::size_t size, std::size_t alignment) noexcept {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+        //Maps size bytes at a 2 MB boundary, so that the kernel can back them with huge pages, and asks for
+        //them. Without transparent huge pages the region simply stays on 4K pages
+        char *map_region(std::size_t size) {
+            regions.reserve(regions.size() + 1);
+            char *address;
+            bool huge = false;
+#ifdef CHUNKLIST_HAS_MMAP
+            std::size_t span = size + region_size;
+            void *mapping = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapping == MAP_FAILED)
+                throw std::bad_alloc();
+            auto start = reinterpret_cast<std::uintptr_t>(mapping);
+            std::uintptr_t aligned = round_up(start, region_size);
+            if (aligned != start)
+                munmap(mapping, aligned - start);
+            if (start + span != aligned + size)
+                munmap(reinterpret_cast<void *>(aligned + size), start + span - (aligned + size));
+            address = reinterpret_cast<char *>(aligned);
+#ifdef MADV_HUGEPAGE
+            huge = madvise(address, size, MADV_HUGEPAGE) == 0 && huge_pages_enabled();
+#endif
+#else
+            address = static_cast<char *>(std::aligned_alloc(region_size, size));
+            if (address == nullptr)
+                throw std::bad_alloc();
+#endif
+            regions.push_back({address, size, huge});
+            usage.regions++;
+            usage.huge_page_regions += huge ? 1 : 0;
+            usage.reserved_bytes += size;
+            return address;
+        }
+
+        //Unmaps the region starting at address, which holds a single oversized block
+        void release_region(char *address) noexcept {
+            auto region = std::find_if(regions.begin(), regions.end(),
+                                       [address](const Region &current) { return current.address == address; });
+            unmap(region->address, region->size);
+            usage.regions--;
+            usage.huge_page_regions -= region->huge ? 1 : 0;
+            usage.reserved_bytes -= region->size;
+            regions.erase(region);
+        }
+
+        static void unmap(char *address, std::size_t size) noexcept {
+#ifdef CHUNKLIST_HAS_MMAP
+            munmap(address, size);
+#else
+            (void) size;
+            std::free(address);
+#endif
+        }
+    };
+
+    //Allocator for chunks of hundreds of kilobytes: every block starts on a page and blocks are packed into
+    //huge-page regions, so that scans touch few TLB entries. All copies and rebinds share one arena
+    template<typename T>
+    class HugePageAllocator {
+        template<typename U>
+        friend class HugePageAllocator;
+
+        std::shared_ptr<HugePageArena> arena = std::make_shared<HugePageArena>();
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T *;
+        using const_pointer = const T *;
+        using reference = T &;
+        using const_reference = const T &;
+
+        HugePageAllocator() = default;
+
+        HugePageAllocator(const HugePageAllocator &other) noexcept = default;
+
+        template<class U>
+        explicit HugePageAllocator(const HugePageAllocator<U> &other) noexcept : arena(other.arena) {}
+
+        ~HugePageAllocator() = default;
+
+        pointer allocate(size_type n) {
+            return static_cast<pointer>(arena->allocate(sizeof(value_type) * n));
+        }
+
+        void deallocate(pointer p, size_type n) noexcept {
+            arena->deallocate(p, sizeof(value_type) * n);
+        }
+
+        const HugePageStats &stats() const noexcept {
+            return arena->stats();
+        }
+
+        template<class U>
+        friend bool operator==(const HugePageAllocator &left, const HugePageAllocator<U> &right) noexcept {
+            return left.arena == right.arena;
+        }
+
+        template<class U>
+        friend bool operator!=(const HugePageAllocator &left, const HugePageAllocator<U> &right) noexcept {
+            return left.arena != right.arena;
+        }
+    };
+}
@@ -0,0 +1,780 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ChunkList.hpp"
+
+namespace fefu_laboratory_two {
+    //Unsigned element of Bits bits. ChunkList<PackedUint<Bits>, N> stores it bit-packed
+    template<int Bits>
+    struct PackedUint {
+        static_assert(Bits >= 1 && Bits <= 8, "PackedUint is 1 to 8 bits wide");
+
+        std::uint8_t value = 0;
+
+        PackedUint(std::uint8_t packed_value = 0) : value(packed_value & ((1u << Bits) - 1)) {}
+
+        operator std::uint8_t() const noexcept {
+            return value;
+        }
+    };
+
+    //Proxy to one element inside a packed word
+    template<int Bits, typename Value>
+    class PackedChunkList_reference {
+        static constexpr std::uint64_t field_mask = (std::uint64_t(1) << Bits) - 1;
+
+        struct no_conversion {
+            no_conversion(std::uint8_t) noexcept {}
+        };
+
+        std::uint64_t *word = nullptr;
+        int shift = 0;
+
+    public:
+        PackedChunkList_reference(std::uint64_t *packed_word, int field_shift) : word(packed_word), shift(field_shift) {}
+
+        PackedChunkList_reference(const PackedChunkList_reference &other) noexcept = default;
+
+        operator Value() const noexcept {
+            return static_cast<Value>(*word >> shift & field_mask);
+        }
+
+        //Lets PackedUint references compare with plain integers, bool references need nothing more
+        operator std::conditional_t<std::is_class_v<Value>, std::uint8_t, no_conversion>() const noexcept {
+            return static_cast<std::uint8_t>(*word >> shift & field_mask);
+        }
+
+        PackedChunkList_reference &operator=(Value value) noexcept {
+            *word = (*word & ~(field_mask << shift)) | (static_cast<std::uint64_t>(value) & field_mask) << shift;
+            return *this;
+        }
+
+        PackedChunkList_reference &operator=(const PackedChunkList_reference &other) noexcept {
+            return *this = static_cast<Value>(other);
+        }
+    };
+
+    //Random access iterator over a packed list, kept as the list's chunk directory and an element index
+    template<int Bits, int N, typename Value>
+    class PackedChunkList_iterator {
+        template<int, int, typename, typename>
+        friend class PackedChunkList;
+
+    protected:
+        static constexpr int fields_per_word = 64 / Bits;
+
+        const std::vector<Chunk<std::uint64_t> *> *directory = nullptr;
+        std::ptrdiff_t index = 0;
+
+        std::uint64_t *word() const noexcept {
+            return &(*directory)[index / N]->chunk[index % N / fields_per_word];
+        }
+
+        int shift() const noexcept {
+            return static_cast<int>(index % N % fields_per_word) * Bits;
+        }
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Value;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = PackedChunkList_reference<Bits, Value>;
+
+        PackedChunkList_iterator() noexcept = default;
+
+        PackedChunkList_iterator(const std::vector<Chunk<std::uint64_t> *> *chunk_directory, difference_type position) :
+                directory(chunk_directory), index(position) {}
+
+        friend bool operator==(const PackedChunkList_iterator &left, const PackedChunkList_iterator &right) {
+            return left.index == right.index;
+        }
+
+        friend bool operator!=(const PackedChunkList_iterator &left, const PackedChunkList_iterator &right) {
+            return left.index != right.index;
+        }
+
+        friend bool operator<(const PackedChunkList_iterator &left, const PackedChunkList_iterator &right) {
+            return left.index < right.index;
+        }
+
+        friend bool operator<=(const PackedChunkList_iterator &left, const PackedChunkList_iterator &right) {
+            return left.index <= right.index;
+        }
+
+        friend bool operator>(const PackedChunkList_iterator &left, const PackedChunkList_iterator &right) {
+            return left.index > right.index;
+        }
+
+        friend bool operator>=(const PackedChunkList_iterator &left, const PackedChunkList_iterator &right) {
+            return left.index >= right.index;
+        }
+
+        friend difference_type operator-(const PackedChunkList_iterator &left, const PackedChunkList_iterator &right) {
+            return left.index - right.index;
+        }
+
+        reference operator*() const {
+            return reference(word(), shift());
+        }
+
+        reference operator[](difference_type offset) const {
+            return *(*this + offset);
+        }
+
+        PackedChunkList_iterator &operator++() {
+            index++;
+            return *this;
+        }
+
+        PackedChunkList_iterator operator++(int) {
+            PackedChunkList_iterator temp(*this);
+            index++;
+            return temp;
+        }
+
+        PackedChunkList_iterator &operator--() {
+            index--;
+            return *this;
+        }
+
+        PackedChunkList_iterator operator--(int) {
+            PackedChunkList_iterator temp(*this);
+            index--;
+            return temp;
+        }
+
+        PackedChunkList_iterator &operator+=(difference_type offset) {
+            index += offset;
+            return *this;
+        }
+
+        PackedChunkList_iterator &operator-=(difference_type offset) {
+            index -= offset;
+            return *this;
+        }
+
+        PackedChunkList_iterator operator+(difference_type offset) const {
+            return PackedChunkList_iterator(directory, index + offset);
+        }
+
+        friend PackedChunkList_iterator operator+(difference_type offset, const PackedChunkList_iterator &iterator) {
+            return iterator + offset;
+        }
+
+        PackedChunkList_iterator operator-(difference_type offset) const {
+            return PackedChunkList_iterator(directory, index - offset);
+        }
+    };
+
+    template<int Bits, int N, typename Value>
+    class PackedChunkList_const_iterator : public PackedChunkList_iterator<Bits, N, Value> {
+        using base = PackedChunkList_iterator<Bits, N, Value>;
+
+    public:
+        using reference = Value;
+
+        PackedChunkList_const_iterator() noexcept = default;
+
+        PackedChunkList_const_iterator(const base &other) noexcept : base(other) {}
+
+        PackedChunkList_const_iterator(const std::vector<Chunk<std::uint64_t> *> *chunk_directory,
+                                       std::ptrdiff_t position) : base(chunk_directory, position) {}
+
+        reference operator*() const {
+            return static_cast<Value>(*this->word() >> this->shift() & ((std::uint64_t(1) << Bits) - 1));
+        }
+
+        reference operator[](std::ptrdiff_t offset) const {
+            return *(*this + offset);
+        }
+
+        PackedChunkList_const_iterator &operator++() {
+            this->index++;
+            return *this;
+        }
+
+        PackedChunkList_const_iterator operator++(int) {
+            PackedChunkList_const_iterator temp(*this);
+            this->index++;
+            return temp;
+        }
+
+        PackedChunkList_const_iterator &operator--() {
+            this->index--;
+            return *this;
+        }
+
+        PackedChunkList_const_iterator operator--(int) {
+            PackedChunkList_const_iterator temp(*this);
+            this->index--;
+            return temp;
+        }
+
+        PackedChunkList_const_iterator &operator+=(std::ptrdiff_t offset) {
+            this->index += offset;
+            return *this;
+        }
+
+        PackedChunkList_const_iterator &operator-=(std::ptrdiff_t offset) {
+            this->index -= offset;
+            return *this;
+        }
+
+        PackedChunkList_const_iterator operator+(std::ptrdiff_t offset) const {
+            return PackedChunkList_const_iterator(this->directory, this->index + offset);
+        }
+
+        friend PackedChunkList_const_iterator operator+(std::ptrdiff_t offset,
+                                                        const PackedChunkList_const_iterator &iterator) {
+            return iterator + offset;
+        }
+
+        PackedChunkList_const_iterator operator-(std::ptrdiff_t offset) const {
+            return PackedChunkList_const_iterator(this->directory, this->index - offset);
+        }
+    };
+
+    //Chain of chunks of N elements of Bits bits, packed into 64-bit words without straddling them. Every
+    //chunk but the last is full, so elements are found through a directory of chunks. Bits past the last
+    //element are kept zero, which lets count, find and comparisons work on whole words
+    template<int Bits, int N, typename Alloc, typename Value>
+    class PackedChunkList {
+        static_assert(Bits >= 1 && Bits <= 8, "Packed elements are 1 to 8 bits wide");
+        static_assert(N > 0, "Chunks hold at least one element");
+
+    protected:
+        using word_chunk = Chunk<std::uint64_t>;
+        using word_allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<std::uint64_t>;
+
+        static constexpr int fields_per_word = 64 / Bits;
+        static constexpr int words_per_chunk = (N + fields_per_word - 1) / fields_per_word;
+        static constexpr std::uint64_t field_mask = (std::uint64_t(1) << Bits) - 1;
+        static constexpr std::uint64_t low_bits = [] { //Lowest bit of every field
+            std::uint64_t bits = 0;
+            for (int i = 0; i < fields_per_word; i++)
+                bits |= std::uint64_t(1) << (i * Bits);
+            return bits;
+        }();
+
+        word_allocator_type word_allocator;
+        std::vector<word_chunk *> directory; //Chunk k holds elements k * N to k * N + N - 1
+        std::size_t list_size = 0;
+
+        //Low bit of every field of word equal to value
+        static std::uint64_t matches(std::uint64_t word, std::uint64_t value) noexcept {
+            std::uint64_t difference = word ^ value * low_bits;
+            std::uint64_t any_bit = difference;
+            for (int i = 1; i < Bits; i++)
+                any_bit |= difference >> i;
+            return ~any_bit & low_bits;
+        }
+
+        //Low bits of fields first to last - 1 of a word
+        static std::uint64_t field_range(int first, int last) noexcept {
+            std::uint64_t below_last = last * Bits == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << last * Bits) - 1;
+            return below_last & ~((std::uint64_t(1) << first * Bits) - 1) & low_bits;
+        }
+
+        //Calls visit(word, fields, index) for every word overlapping elements first to last - 1, where fields
+        //holds the low bits of the fields in range and index is the element in the word's field 0. Stops
+        //early when visit returns false
+        template<typename WordVisitor>
+        void for_each_word(std::size_t first, std::size_t last, WordVisitor visit) const {
+            while (first < last) {
+                word_chunk *current_chunk = directory[first / N];
+                int slot = static_cast<int>(first % N);
+                int field = slot % fields_per_word;
+                int word_end = std::min(fields_per_word, N - (slot - field));
+                int field_end = static_cast<int>(std::min<std::size_t>(word_end, field + (last - first)));
+                if (!visit(current_chunk->chunk[slot / fields_per_word], field_range(field, field_end), first - field))
+                    return;
+                first += field_end - field;
+            }
+        }
+
+        //Low bits of a word which hold fields fields
+        static std::uint64_t word_bits(int fields) noexcept {
+            return fields * Bits == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << fields * Bits) - 1;
+        }
+
+        //Number of fields word holds in a chunk, the last word may hold fewer
+        static int fields_in_word(int word) noexcept {
+            return std::min(fields_per_word, N - word * fields_per_word);
+        }
+
+        //Puts carry at slot of current_chunk and moves the later fields up by one. Returns the field moved out
+        //of the last slot
+        static std::uint64_t shift_up(word_chunk *current_chunk, int slot, std::uint64_t carry) noexcept {
+            for (int word = slot / fields_per_word; word < words_per_chunk; word++) {
+                int field = word == slot / fields_per_word ? slot % fields_per_word : 0;
+                int fields = fields_in_word(word);
+                std::uint64_t &packed = current_chunk->chunk[word];
+                std::uint64_t moved_out = packed >> (fields - 1) * Bits & field_mask;
+                std::uint64_t below = packed & word_bits(field);
+                packed = (below | carry << field * Bits | (packed & ~below) << Bits) & word_bits(fields);
+                carry = moved_out;
+            }
+            return carry;
+        }
+
+        //Takes the field at slot out of current_chunk, moves the later fields down by one and puts carry in the
+        //last slot. Returns the field taken out
+        static std::uint64_t shift_down(word_chunk *current_chunk, int slot, std::uint64_t carry) noexcept {
+            for (int word = words_per_chunk - 1; word >= slot / fields_per_word; word--) {
+                int field = word == slot / fields_per_word ? slot % fields_per_word : 0;
+                int fields = fields_in_word(word);
+                std::uint64_t &packed = current_chunk->chunk[word];
+                std::uint64_t taken_out = packed >> field * Bits & field_mask;
+                std::uint64_t above = packed >> Bits & ~word_bits(field) & word_bits(fields - 1);
+                packed = (packed & word_bits(field)) | above | carry << (fields - 1) * Bits;
+                carry = taken_out;
+            }
+            return carry;
+        }
+
+        //Inserts value at index, shifting every later element up a word at a time
+        void insert_at(std::size_t index, const Value &value) {
+            if (index > list_size) throw std::out_of_range("Out of bounds");
+            if (list_size % N == 0)
+                append_chunk();
+            directory.back()->current_chunk_size++;
+            list_size++;
+            std::uint64_t carry = static_cast<std::uint64_t>(value) & field_mask;
+            for (std::size_t k = index / N; k < directory.size(); k++)
+                carry = shift_up(directory[k], k == index / N ? static_cast<int>(index % N) : 0, carry);
+        }
+
+        //Removes the element at index, shifting every later element down a word at a time
+        void erase_at(std::size_t index) {
+            if (index >= list_size) throw std::out_of_range("Out of bounds");
+            std::uint64_t carry = 0;
+            for (std::size_t k = directory.size(); k-- > index / N;)
+                carry = shift_down(directory[k], k == index / N ? static_cast<int>(index % N) : 0, carry);
+            list_size--;
+            if (--directory.back()->current_chunk_size == 0)
+                drop_last_chunk();
+        }
+
+        word_chunk *allocate_chunk() {
+            auto *new_chunk = new word_chunk();
+            try {
+                new_chunk->chunk = word_allocator.allocate(words_per_chunk);
+            } catch (...) {
+                delete new_chunk;
+                throw;
+            }
+            std::fill(new_chunk->chunk, new_chunk->chunk + words_per_chunk, 0);
+            new_chunk->chunk_size = N;
+            return new_chunk;
+        }
+
+        void free_chunk(word_chunk *old_chunk) noexcept {
+            word_allocator.deallocate(old_chunk->chunk, words_per_chunk);
+            old_chunk->chunk = nullptr;
+            delete old_chunk;
+        }
+
+        //Appends a zeroed chunk, linked after the current last one
+        void append_chunk() {
+            directory.reserve(directory.size() + 1);
+            word_chunk *new_chunk = allocate_chunk();
+            if (!directory.empty()) {
+                new_chunk->prev = directory.back();
+                directory.back()->next = new_chunk;
+            }
+            directory.push_back(new_chunk);
+        }
+
+        void drop_last_chunk() noexcept {
+            word_chunk *old_chunk = directory.back();
+            directory.pop_back();
+            if (!directory.empty())
+                directory.back()->next = nullptr;
+            free_chunk(old_chunk);
+        }
+
+    public:
+        using value_type = Value;
+        using allocator_type = Alloc;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = PackedChunkList_reference<Bits, Value>;
+        using const_reference = Value;
+        using iterator = PackedChunkList_iterator<Bits, N, Value>;
+        using const_iterator = PackedChunkList_const_iterator<Bits, N, Value>;
+
+        PackedChunkList() = default;
+
+        explicit PackedChunkList(const Alloc &alloc) : word_allocator(alloc) {}
+
+        PackedChunkList(size_type count, const Value &value, const Alloc &alloc = Alloc()) : word_allocator(alloc) {
+            resize(count, value);
+        }
+
+        explicit PackedChunkList(size_type count, const Alloc &alloc = Alloc()) : word_allocator(alloc) {
+            resize(count);
+        }
+
+        PackedChunkList(std::initializer_list<Value> init, const Alloc &alloc = Alloc()) : word_allocator(alloc) {
+            for (const Value &value : init)
+                push_back(value);
+        }
+
+        PackedChunkList(const PackedChunkList &other) : word_allocator(other.word_allocator) {
+            try {
+                for (word_chunk *other_chunk : other.directory) {
+                    append_chunk();
+                    std::copy(other_chunk->chunk, other_chunk->chunk + words_per_chunk, directory.back()->chunk);
+                    directory.back()->current_chunk_size = other_chunk->current_chunk_size;
+                }
+            } catch (...) {
+                clear();
+                throw;
+            }
+            list_size = other.list_size;
+        }
+
+        PackedChunkList(PackedChunkList &&other) noexcept : word_allocator(other.word_allocator),
+                                                             directory(std::move(other.directory)),
+                                                             list_size(other.list_size) {
+            other.directory.clear();
+            other.list_size = 0;
+        }
+
+        ~PackedChunkList() {
+            clear();
+        }
+
+        PackedChunkList &operator=(const PackedChunkList &other) {
+            if (this != &other) {
+                PackedChunkList copy(other);
+                swap(copy);
+            }
+            return *this;
+        }
+
+        PackedChunkList &operator=(PackedChunkList &&other) noexcept {
+            if (this != &other) {
+                clear();
+                swap(other);
+            }
+            return *this;
+        }
+
+        PackedChunkList &operator=(std::initializer_list<Value> ilist) {
+            assign(ilist);
+            return *this;
+        }
+
+        void assign(size_type count, const Value &value) {
+            clear();
+            resize(count, value);
+        }
+
+        void assign(std::initializer_list<Value> ilist) {
+            clear();
+            for (const Value &value : ilist)
+                push_back(value);
+        }
+
+        allocator_type get_allocator() const noexcept {
+            return allocator_type(word_allocator);
+        }
+
+        size_type size() const noexcept {
+            return list_size;
+        }
+
+        bool empty() const noexcept {
+            return list_size == 0;
+        }
+
+        size_type max_size() const noexcept {
+            return directory.size() * N;
+        }
+
+        //Every chunk but the last is full, so only the directory can shrink
+        void shrink_to_fit() {
+            directory.shrink_to_fit();
+        }
+
+        reference operator[](size_type pos) {
+            word_chunk *current_chunk = directory[pos / N];
+            int slot = static_cast<int>(pos % N);
+            return reference(&current_chunk->chunk[slot / fields_per_word], slot % fields_per_word * Bits);
+        }
+
+        const_reference operator[](size_type pos) const {
+            const word_chunk *current_chunk = directory[pos / N];
+            int slot = static_cast<int>(pos % N);
+            return static_cast<Value>(current_chunk->chunk[slot / fields_per_word] >> (slot % fields_per_word * Bits) &
+                                      field_mask);
+        }
+
+        reference at(size_type pos) {
+            if (pos >= list_size) throw std::out_of_range("Out of bounds");
+            return operator[](pos);
+        }
+
+        const_reference at(size_type pos) const {
+            if (pos >= list_size) throw std::out_of_range("Out of bounds");
+            return operator[](pos);
+        }
+
+        reference front() {
+            if (list_size == 0) throw std::runtime_error("Empty");
+            return operator[](0);
+        }
+
+        const_reference front() const {
+            if (list_size == 0) throw std::runtime_error("Empty");
+            return operator[](0);
+        }
+
+        reference back() {
+            if (list_size == 0) throw std::runtime_error("Empty");
+            return operator[](list_size - 1);
+        }
+
+        const_reference back() const {
+            if (list_size == 0) throw std::runtime_error("Empty");
+            return operator[](list_size - 1);
+        }
+
+        iterator begin() noexcept {
+            return iterator(&directory, 0);
+        }
+
+        const_iterator begin() const noexcept {
+            return const_iterator(&directory, 0);
+        }
+
+        const_iterator cbegin() const noexcept {
+            return begin();
+        }
+
+        iterator end() noexcept {
+            return iterator(&directory, static_cast<std::ptrdiff_t>(list_size));
+        }
+
+        const_iterator end() const noexcept {
+            return const_iterator(&directory, static_cast<std::ptrdiff_t>(list_size));
+        }
+
+        const_iterator cend() const noexcept {
+            return end();
+        }
+
+        void push_back(const Value &value) {
+            if (list_size % N == 0)
+                append_chunk();
+            directory.back()->current_chunk_size++;
+            operator[](list_size++) = value;
+        }
+
+        template<class... Args>
+        reference emplace_back(Args &&... args) {
+            push_back(Value(std::forward<Args>(args)...));
+            return back();
+        }
+
+        //Inserting or erasing anywhere but the back shifts the later elements of every chunk a word at a time
+        iterator insert(const_iterator pos, const Value &value) {
+            insert_at(pos.index, value);
+            return iterator(&directory, pos.index);
+        }
+
+        iterator insert(const_iterator pos, size_type count, const Value &value) {
+            for (size_type i = 0; i < count; i++)
+                insert_at(pos.index, value);
+            return iterator(&directory, pos.index);
+        }
+
+        iterator insert(const_iterator pos, std::initializer_list<Value> ilist) {
+            size_type index = pos.index;
+            for (const Value &value : ilist)
+                insert_at(index++, value);
+            return iterator(&directory, pos.index);
+        }
+
+        template<class... Args>
+        iterator emplace(const_iterator pos, Args &&... args) {
+            return insert(pos, Value(std::forward<Args>(args)...));
+        }
+
+        iterator erase(const_iterator pos) {
+            erase_at(pos.index);
+            return iterator(&directory, pos.index);
+        }
+
+        iterator erase(const_iterator first, const_iterator last) {
+            for (std::ptrdiff_t i = first.index; i < last.index; i++)
+                erase_at(first.index);
+            return iterator(&directory, first.index);
+        }
+
+        void push_front(const Value &value) {
+            insert_at(0, value);
+        }
+
+        template<class... Args>
+        reference emplace_front(Args &&... args) {
+            insert_at(0, Value(std::forward<Args>(args)...));
+            return front();
+        }
+
+        void pop_front() {
+            erase_at(0);
+        }
+
+        void pop_back() {
+            if (list_size == 0)
+                throw std::runtime_error("Empty");
+            operator[](--list_size) = Value();
+            if (--directory.back()->current_chunk_size == 0)
+                drop_last_chunk();
+        }
+
+        void clear() noexcept {
+            while (!directory.empty())
+                drop_last_chunk();
+            list_size = 0;
+        }
+
+        void resize(size_type count, const Value &value = Value()) {
+            while (list_size > count && list_size % N != 0)
+                pop_back();
+            while (list_size >= count + N) {
+                list_size -= N;
+                drop_last_chunk();
+            }
+            while (list_size > count)
+                pop_back();
+            size_type old_size = list_size;
+            while (list_size < count) {
+                if (list_size % N == 0)
+                    append_chunk();
+                int added = static_cast<int>(std::min<size_type>(N - list_size % N, count - list_size));
+                directory.back()->current_chunk_size += added;
+                list_size += added;
+            }
+            fill(old_size, list_size, value);
+        }
+
+        //Sets elements first to last - 1 to value, a word at a time
+        void fill(size_type first, size_type last, const Value &value) {
+            if (first > last || last > list_size) throw std::out_of_range("Out of bounds");
+            std::uint64_t pattern = (static_cast<std::uint64_t>(value) & field_mask) * low_bits;
+            for_each_word(first, last, [pattern](std::uint64_t &word, std::uint64_t fields, size_type) {
+                std::uint64_t bits = fields * field_mask;
+                word = (word & ~bits) | (pattern & bits);
+                return true;
+            });
+        }
+
+        void fill(const Value &value) {
+            fill(0, list_size, value);
+        }
+
+        //Number of elements equal to value, counted with one popcount per word
+        size_type count(const Value &value) const {
+            size_type found = 0;
+            std::uint64_t key = static_cast<std::uint64_t>(value) & field_mask;
+            for_each_word(0, list_size, [key, &found](std::uint64_t word, std::uint64_t fields, size_type) {
+                found += word_chunk::bit_count(matches(word, key) & fields);
+                return true;
+            });
+            return found;
+        }
+
+        //Position of the first element equal to value at or after from, size() when there is none
+        size_type find(const Value &value, size_type from = 0) const {
+            size_type found = list_size;
+            std::uint64_t key = static_cast<std::uint64_t>(value) & field_mask;
+            for_each_word(from, list_size, [key, &found](std::uint64_t word, std::uint64_t fields, size_type index) {
+                std::uint64_t hits = matches(word, key) & fields;
+                if (hits == 0)
+                    return true;
+                found = index + word_chunk::lowest_bit(hits) / Bits;
+                return false;
+            });
+            return found;
+        }
+
+        ChunkListStats stats() const noexcept {
+            ChunkListStats result;
+            for (const word_chunk *current_chunk : directory) {
+                result.chunk_count++;
+                result.fill_histogram[current_chunk->current_chunk_size * 10 / N]++;
+            }
+            result.live_bytes = (list_size * Bits + 7) / 8;
+            result.slack_bytes = result.chunk_count * words_per_chunk * sizeof(std::uint64_t) - result.live_bytes;
+            result.header_overhead = result.chunk_count * sizeof(word_chunk);
+            return result;
+        }
+
+        void swap(PackedChunkList &other) noexcept {
+            std::swap(word_allocator, other.word_allocator);
+            directory.swap(other.directory);
+            std::swap(list_size, other.list_size);
+        }
+
+        //Chunks of equal lists have equal words, since both are full up to the last one and zero past the end
+        friend bool operator==(const PackedChunkList &lhs, const PackedChunkList &rhs) {
+            if (lhs.list_size != rhs.list_size)
+                return false;
+            for (std::size_t i = 0; i < lhs.directory.size(); i++) {
+                if (std::memcmp(lhs.directory[i]->chunk, rhs.directory[i]->chunk,
+                                words_per_chunk * sizeof(std::uint64_t)) != 0)
+                    return false;
+            }
+            return true;
+        }
+
+        friend bool operator!=(const PackedChunkList &lhs, const PackedChunkList &rhs) {
+            return !(lhs == rhs);
+        }
+
+        friend bool operator<(const PackedChunkList &lhs, const PackedChunkList &rhs) {
+            return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+        }
+
+        friend bool operator>(const PackedChunkList &lhs, const PackedChunkList &rhs) {
+            return rhs < lhs;
+        }
+
+        friend bool operator<=(const PackedChunkList &lhs, const PackedChunkList &rhs) {
+            return !(rhs < lhs);
+        }
+
+        friend bool operator>=(const PackedChunkList &lhs, const PackedChunkList &rhs) {
+            return !(lhs < rhs);
+        }
+    };
+
+    //One bit per element
+    template<int N, typename Alloc>
+    class ChunkList<bool, N, Alloc> : public PackedChunkList<1, N, Alloc, bool> {
+    public:
+        using PackedChunkList<1, N, Alloc, bool>::PackedChunkList;
+    };
+
+    //Bits bits per element
+    template<int Bits, int N, typename Alloc>
+    class ChunkList<PackedUint<Bits>, N, Alloc> : public PackedChunkList<Bits, N, Alloc, PackedUint<Bits>> {
+    public:
+        using PackedChunkList<Bits, N, Alloc, PackedUint<Bits>>::PackedChunkList;
+    };
+}
@@ -1,5 +1,15 @@
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "../ChunkList/ChunkList.hpp"
+#include "../ChunkList/ChunkedSoA.hpp"
+#include "../ChunkList/CompressedChunkList.hpp"
+#include "../ChunkList/HugePageAllocator.hpp"
 
 using namespace fefu_laboratory_two;
 
@@ -105,6 +115,1500 @@ TEST(ChunkListTest, ModifiedIteratorsTest) {
 }
 
 
+TEST(ChunkListTest, StatsTest) {
+    ChunkList<int, 4> custom_list;
+    for (int custom_value = 0; custom_value < 10; custom_value++) {
+        custom_list.push_back(custom_value);
+    }
+    auto custom_stats = custom_list.stats();
+    ASSERT_EQ(3, custom_stats.chunk_count);
+    ASSERT_EQ(2, custom_stats.fill_histogram[10]);
+    ASSERT_EQ(1, custom_stats.fill_histogram[5]);
+    ASSERT_EQ(10 * sizeof(int), custom_stats.live_bytes);
+    ASSERT_EQ(2 * sizeof(int), custom_stats.slack_bytes);
+    ASSERT_EQ(3 * sizeof(Chunk<int>), custom_stats.header_overhead);
+}
+
+#ifdef CHUNKLIST_ENABLE_COUNTERS
+TEST(ChunkListTest, CountersTest) {
+    ChunkList<int, 4> custom_list;
+    for (int custom_value = 0; custom_value < 12; custom_value++) {
+        custom_list.push_back(custom_value);
+    }
+    auto custom_counters = custom_list.stats().counters;
+    ASSERT_EQ(3, custom_counters.chunk_allocations);
+    ASSERT_EQ(0, custom_counters.chunk_frees);
+    ASSERT_EQ(0, custom_counters.steps(ChunkListOperation::push));
+    for (int custom_index = 0; custom_index < 4; custom_index++) {
+        custom_list.pop_back();
+    }
+    ASSERT_EQ(1, custom_list.stats().counters.chunk_frees);
+    custom_list.reset_counters();
+    custom_list.clear();
+    ASSERT_EQ(2, custom_list.stats().counters.chunk_frees);
+
+    ChunkList<int, 4> custom_producer;
+    for (int custom_value = 0; custom_value < 12; custom_value++) {
+        custom_producer.push_back(custom_value);
+    }
+    ChunkList<int, 4> custom_consumer;
+    custom_consumer.adopt_back(custom_producer.drain_front_chunk());
+    custom_consumer.adopt_back(custom_producer.drain_front_chunk());
+    auto custom_balance = [](const ChunkListStats &stats) {
+        return stats.counters.chunk_allocations - stats.counters.chunk_frees - stats.pooled_chunks;
+    };
+    ASSERT_EQ(1, custom_producer.stats().chunk_count);
+    ASSERT_EQ(custom_producer.stats().chunk_count, custom_balance(custom_producer.stats()));
+    ASSERT_EQ(custom_consumer.stats().chunk_count, custom_balance(custom_consumer.stats()));
+    ASSERT_EQ(2, custom_consumer.stats().chunk_count);
+}
+#endif
+
+#ifdef CHUNKLIST_ENABLE_TRACE
+TEST(ChunkListTest, TraceRecorderTest) {
+    ChunkListTraceRecorder custom_recorder;
+    ChunkList<int, 4> custom_list;
+    custom_list.set_trace_recorder(&custom_recorder);
+    for (int custom_value = 0; custom_value < 6; custom_value++) {
+        custom_list.push_back(custom_value);
+    }
+    custom_list.push_front(-1);
+    auto custom_it = custom_list.begin();
+    for (int custom_index = 0; custom_index < 5; custom_index++) {
+        ++custom_it;
+    }
+    custom_list.erase(custom_it);
+    ASSERT_EQ(5, custom_list[5]);
+    custom_list.pop_back();
+    custom_list.clear();
+    custom_list.set_trace_recorder(nullptr);
+    custom_list.push_back(7);
+
+    std::vector<TraceRecord> custom_records = custom_recorder.records();
+    ASSERT_EQ(11, custom_records.size());
+    ASSERT_EQ(TraceOperation::push_back, custom_records[5].operation);
+    ASSERT_EQ(5, custom_records[5].position);
+    ASSERT_EQ(TraceOperation::insert, custom_records[6].operation);
+    ASSERT_EQ(0, custom_records[6].position);
+    ASSERT_EQ(6, custom_records[6].size);
+    ASSERT_EQ(TraceOperation::erase, custom_records[7].operation);
+    ASSERT_EQ(5, custom_records[7].position);
+    ASSERT_EQ(TraceOperation::access, custom_records[8].operation);
+    ASSERT_EQ(TraceOperation::pop_back, custom_records[9].operation);
+    ASSERT_EQ(5, custom_records[9].position);
+    ASSERT_EQ(TraceOperation::clear, custom_records[10].operation);
+    ASSERT_EQ(5, custom_records[10].size);
+    ASSERT_EQ(3 * 11, custom_recorder.encoded_bytes());
+
+    std::string custom_path = ::testing::TempDir() + "chunklist_trace_test.bin";
+    custom_recorder.save(custom_path);
+    ChunkListTraceRecorder custom_loaded = ChunkListTraceRecorder::load(custom_path);
+    std::remove(custom_path.c_str());
+    ASSERT_EQ(sizeof(int), custom_loaded.element_size());
+    ASSERT_EQ(11, custom_loaded.size());
+    ASSERT_EQ(TraceOperation::erase, custom_loaded.records()[7].operation);
+
+    ChunkListTraceRecorder custom_erasures;
+    ChunkList<int, 4> custom_numbers;
+    for (int custom_value = 0; custom_value < 40; custom_value++) {
+        custom_numbers.push_back(custom_value);
+    }
+    custom_numbers.set_trace_recorder(&custom_erasures);
+    auto custom_next = ++custom_numbers.begin();
+    for (int custom_index = 0; custom_index < 10; custom_index++) {
+        custom_next = custom_numbers.erase(custom_next);
+        ++custom_next;
+        ++custom_next;
+    }
+    custom_numbers.pop_front();
+    auto custom_third = custom_numbers.cbegin();
+    ++custom_third;
+    ++custom_third;
+    custom_numbers.insert(custom_third, 100);
+    std::vector<TraceRecord> custom_erased = custom_erasures.records();
+    ASSERT_EQ(12, custom_erased.size());
+    for (int custom_index = 0; custom_index < 10; custom_index++) {
+        ASSERT_EQ(1 + 2 * custom_index, custom_erased[custom_index].position);
+    }
+    ASSERT_EQ(0, custom_erased[10].position);
+    ASSERT_EQ(2, custom_erased[11].position);
+    ASSERT_EQ(TraceOperation::insert, custom_erased[11].operation);
+
+    {
+        ChunkList<int, 4> custom_outliving;
+        ChunkListTraceRecorder custom_short_lived;
+        custom_outliving.set_trace_recorder(&custom_short_lived);
+        custom_outliving.push_back(1);
+        ASSERT_EQ(1, custom_short_lived.size());
+    }
+}
+#endif
+
+TEST(ChunkListTest, PushBackAllocationBudgetTest) {
+    CountingAllocator<int> custom_allocator;
+    ChunkList<int, 4, CountingAllocator<int>> custom_list(custom_allocator);
+    for (int custom_value = 0; custom_value < 5 * 4; custom_value++) {
+        custom_list.push_back(custom_value);
+    }
+    ASSERT_EQ(5, custom_allocator.stats().allocations);
+    ASSERT_EQ(0, custom_allocator.stats().deallocations);
+    ASSERT_EQ(5 * 4 * sizeof(int), custom_allocator.stats().peak_bytes_in_use);
+    ASSERT_EQ(5, custom_allocator.stats().size_histogram.at(4 * sizeof(int)));
+}
+
+TEST(ChunkListTest, PooledRefillAllocationBudgetTest) {
+    CountingAllocator<int> custom_allocator;
+    ChunkList<int, 4, CountingAllocator<int>> custom_list(custom_allocator);
+    custom_list.set_chunk_pool_limit(3);
+    for (int custom_value = 0; custom_value < 12; custom_value++) {
+        custom_list.push_back(custom_value);
+    }
+    custom_allocator.reset();
+    custom_list.clear();
+    ASSERT_EQ(3, custom_list.chunk_pool_size());
+    for (int custom_value = 0; custom_value < 12; custom_value++) {
+        custom_list.push_back(custom_value);
+    }
+    ASSERT_EQ(0, custom_allocator.stats().allocations);
+    ASSERT_EQ(0, custom_allocator.stats().deallocations);
+    ASSERT_EQ(11, custom_list.back());
+}
+
+TEST(ChunkListTest, FailedAllocationTest) {
+    CountingAllocator<int> custom_allocator;
+    ChunkList<int, 2, CountingAllocator<int>> custom_list(custom_allocator);
+    custom_allocator.fail_nth_allocation(2);
+    for (int custom_value = 0; custom_value < 4; custom_value++) {
+        custom_list.push_back(custom_value);
+    }
+    ASSERT_THROW(custom_list.push_back(4), std::bad_alloc);
+    ASSERT_EQ(4, custom_list.size());
+    ASSERT_EQ(3, custom_list.back());
+    ASSERT_EQ(1, custom_allocator.stats().failed_allocations);
+    custom_list.push_back(4);
+    ASSERT_EQ(4, custom_list.back());
+}
+
+TEST(ChunkListTest, DestructorReleasesChunksTest) {
+    CountingAllocator<int> custom_allocator;
+    {
+        ChunkList<int, 3, CountingAllocator<int>> custom_list(custom_allocator);
+        custom_list.set_chunk_pool_limit(1);
+        for (int custom_value = 0; custom_value < 10; custom_value++) {
+            custom_list.push_back(custom_value);
+        }
+        ChunkList<int, 3, CountingAllocator<int>> custom_copy(custom_list);
+        ASSERT_EQ(custom_list.size(), custom_copy.size());
+    }
+    ASSERT_EQ(custom_allocator.stats().allocations, custom_allocator.stats().deallocations);
+    ASSERT_EQ(0, custom_allocator.stats().bytes_in_use);
+}
+
+TEST(ChunkListTest, ComparisonTest) {
+    ChunkList<int, 3> first_list;
+    ChunkList<int, 3> second_list;
+    for (int custom_value = 0; custom_value < 10; custom_value++) {
+        first_list.push_back(custom_value);
+        second_list.push_back(custom_value);
+    }
+    ASSERT_TRUE(first_list == second_list);
+    ASSERT_TRUE(first_list <= second_list);
+    ASSERT_FALSE(first_list < second_list);
+
+    second_list.push_back(10);
+    ASSERT_FALSE(first_list == second_list);
+    ASSERT_TRUE(first_list < second_list);
+    ASSERT_TRUE(second_list > first_list);
+
+    first_list.pop_back();
+    first_list.push_back(100);
+    ASSERT_TRUE(first_list != second_list);
+    ASSERT_TRUE(first_list > second_list);
+    ASSERT_TRUE(second_list <= first_list);
+    ASSERT_FALSE(second_list >= first_list);
+}
+
+TEST(ChunkListTest, NonBytewiseComparisonTest) {
+    ChunkList<double, 4> first_list;
+    ChunkList<double, 4> second_list;
+    for (int custom_value = 0; custom_value < 9; custom_value++) {
+        first_list.push_back(custom_value == 4 ? 0.0 : custom_value);
+        second_list.push_back(custom_value == 4 ? -0.0 : custom_value);
+    }
+    ASSERT_TRUE(first_list == second_list);
+    second_list.pop_back();
+    second_list.push_back(7.5);
+    ASSERT_TRUE(second_list < first_list);
+}
+
+TEST(ChunkListTest, SortTest) {
+    ChunkList<int, 4> custom_list;
+    for (int custom_value = 0; custom_value < 103; custom_value++) {
+        custom_list.push_back((custom_value * 37) % 103);
+    }
+    custom_list.sort();
+    ASSERT_EQ(103, custom_list.size());
+    for (int custom_index = 0; custom_index < 103; custom_index++) {
+        ASSERT_EQ(custom_index, custom_list[custom_index]);
+    }
+    custom_list.sort(std::greater<>());
+    ASSERT_EQ(102, custom_list.front());
+    ASSERT_EQ(0, custom_list.back());
+}
+
+TEST(ChunkListTest, StableSortTest) {
+    ChunkList<std::pair<int, int>, 3> custom_list;
+    for (int custom_value = 0; custom_value < 20; custom_value++) {
+        custom_list.push_back({custom_value % 4, custom_value});
+    }
+    custom_list.stable_sort([](const std::pair<int, int> &left, const std::pair<int, int> &right) {
+        return left.first < right.first;
+    });
+    for (int custom_index = 1; custom_index < 20; custom_index++) {
+        ASSERT_LE(custom_list[custom_index - 1].first, custom_list[custom_index].first);
+        if (custom_list[custom_index - 1].first == custom_list[custom_index].first) {
+            ASSERT_LT(custom_list[custom_index - 1].second, custom_list[custom_index].second);
+        }
+    }
+}
+
+TEST(ChunkListTest, SortAllocationBudgetTest) {
+    CountingAllocator<int> custom_allocator;
+    ChunkList<int, 4, CountingAllocator<int>> custom_list(custom_allocator);
+    for (int custom_value = 0; custom_value < 100; custom_value++) {
+        custom_list.push_back(99 - custom_value);
+    }
+    custom_allocator.reset();
+    custom_list.sort();
+    ASSERT_EQ(1, custom_allocator.stats().allocations);
+    ASSERT_EQ(1, custom_allocator.stats().deallocations);
+    ASSERT_EQ(0, custom_list.front());
+    ASSERT_EQ(99, custom_list.back());
+
+    custom_list.push_back(-1);
+    custom_allocator.fail_nth_allocation(1);
+    ASSERT_THROW(custom_list.sort(), std::bad_alloc);
+    ASSERT_EQ(101, custom_list.size());
+    long long custom_sum = 0;
+    for (int custom_index = 0; custom_index < 101; custom_index++) {
+        custom_sum += custom_list[custom_index];
+    }
+    ASSERT_EQ(99 * 100 / 2 - 1, custom_sum);
+}
+
+TEST(ChunkListTest, MergeTest) {
+    ChunkList<int, 3> first_list;
+    ChunkList<int, 3> second_list;
+    for (int custom_value = 0; custom_value < 20; custom_value++) {
+        first_list.push_back(2 * custom_value);
+    }
+    for (int custom_value = 0; custom_value < 7; custom_value++) {
+        second_list.push_back(2 * custom_value + 1);
+    }
+    first_list.merge(std::move(second_list));
+    ASSERT_TRUE(second_list.empty());
+    ASSERT_EQ(27, first_list.size());
+    for (int custom_index = 0; custom_index < 14; custom_index++) {
+        ASSERT_EQ(custom_index, first_list[custom_index]);
+    }
+    ASSERT_EQ(38, first_list.back());
+    second_list.push_back(5);
+    ASSERT_EQ(1, second_list.size());
+}
+
+TEST(ChunkListTest, MergeIntoLazyEraseTest) {
+    ChunkList<int, 3> first_list;
+    ChunkList<int, 3> second_list;
+    first_list.enable_lazy_erase();
+    for (int custom_value = 0; custom_value < 10; custom_value++) {
+        first_list.push_back(2 * custom_value);
+        second_list.push_back(2 * custom_value + 1);
+    }
+    first_list.merge(std::move(second_list));
+    for (int custom_index = 0; custom_index < 10; custom_index++) {
+        auto custom_position = first_list.begin();
+        for (int i = 0; i < custom_index; i++)
+            ++custom_position;
+        first_list.erase(custom_position);
+    }
+    ASSERT_EQ(10, first_list.size());
+    for (int custom_index = 0; custom_index < 10; custom_index++) {
+        ASSERT_EQ(2 * custom_index + 1, first_list[custom_index]);
+    }
+}
+
+TEST(ChunkListTest, SortedModeInsertTest) {
+    ChunkList<int, 4> custom_list;
+    custom_list.enable_sorted_mode();
+    for (int custom_value = 0; custom_value < 50; custom_value++) {
+        auto custom_it = custom_list.insert_sorted((custom_value * 17) % 25);
+        ASSERT_EQ((custom_value * 17) % 25, *custom_it);
+    }
+    ASSERT_EQ(50, custom_list.size());
+    int custom_count = 0;
+    for (auto custom_iter = custom_list.begin(); custom_iter != custom_list.end(); ++custom_iter) {
+        ASSERT_EQ(custom_count / 2, *custom_iter);
+        custom_count++;
+    }
+    ASSERT_EQ(50, custom_count);
+}
+
+TEST(ChunkListTest, SortedModeLookupTest) {
+    ChunkList<int, 3> custom_list;
+    for (int custom_value = 0; custom_value < 30; custom_value++) {
+        custom_list.push_back((29 - custom_value) / 2 * 2);
+    }
+    custom_list.enable_sorted_mode();
+    ASSERT_EQ(0, custom_list.front());
+    ASSERT_TRUE(custom_list.contains(28));
+    ASSERT_FALSE(custom_list.contains(27));
+    ASSERT_FALSE(custom_list.contains(100));
+    auto custom_range = custom_list.equal_range(14);
+    int custom_count = 0;
+    for (auto custom_iter = custom_range.first; custom_iter != custom_range.second; ++custom_iter) {
+        ASSERT_EQ(14, *custom_iter);
+        custom_count++;
+    }
+    ASSERT_EQ(2, custom_count);
+    ASSERT_EQ(16, *custom_list.lower_bound(15));
+    ASSERT_TRUE(custom_list.upper_bound(28) == custom_list.end());
+
+    custom_list.push_back(40);
+    ASSERT_TRUE(custom_list.contains(40));
+}
+
+TEST(ChunkListTest, SortedModeSingleElementChunksTest) {
+    ChunkList<int, 1> custom_list;
+    custom_list.enable_sorted_mode();
+    int custom_values[] = {5, 1, 9, 5, 3, 0, 9};
+    for (int custom_value : custom_values) {
+        custom_list.insert_sorted(custom_value);
+    }
+    int custom_expected[] = {0, 1, 3, 5, 5, 9, 9};
+    for (int custom_index = 0; custom_index < 7; custom_index++) {
+        ASSERT_EQ(custom_expected[custom_index], custom_list[custom_index]);
+    }
+    ASSERT_EQ(7, custom_list.stats().chunk_count);
+}
+
+TEST(ChunkListTest, EraseTest) {
+    ChunkList<int, 4> custom_list;
+    for (int custom_value = 0; custom_value < 12; custom_value++) {
+        custom_list.push_back(custom_value);
+    }
+    auto custom_it = custom_list.erase(custom_list.begin());
+    ASSERT_EQ(1, *custom_it);
+    custom_list.pop_front();
+    ASSERT_EQ(2, custom_list.front());
+    ASSERT_EQ(10, custom_list.size());
+
+    custom_it = custom_list.begin();
+    for (int custom_index = 0; custom_index < 2; custom_index++) {
+        ++custom_it;
+    }
+    custom_it = custom_list.erase(custom_it, custom_list.end());
+    ASSERT_TRUE(custom_it == custom_list.end());
+    ASSERT_EQ(2, custom_list.size());
+    ASSERT_EQ(3, custom_list.back());
+    ASSERT_EQ(1, custom_list.stats().chunk_count);
+}
+
+TEST(ChunkListTest, LazyEraseTest) {
+    ChunkList<int, 8> custom_list;
+    custom_list.enable_lazy_erase(0.5);
+    for (int custom_value = 0; custom_value < 40; custom_value++) {
+        custom_list.push_back(custom_value);
+    }
+    auto custom_it = custom_list.begin();
+    while (custom_it != custom_list.end()) {
+        if (*custom_it % 3 == 0) {
+            custom_it = custom_list.erase(custom_it);
+        } else {
+            ++custom_it;
+        }
+    }
+    ASSERT_EQ(26, custom_list.size());
+    ASSERT_GT(custom_list.stats().tombstones, 0);
+    int custom_expected = 1;
+    for (int custom_value : custom_list) {
+        ASSERT_EQ(custom_expected, custom_value);
+        custom_expected += custom_expected % 3 == 1 ? 1 : 2;
+    }
+    ASSERT_EQ(1, custom_list[0]);
+    ASSERT_EQ(2, custom_list[1]);
+    ASSERT_EQ(4, custom_list[2]);
+    ASSERT_EQ(38, custom_list[25]);
+    ASSERT_EQ(1, custom_list.front());
+    ASSERT_EQ(38, custom_list.back());
+
+    ChunkList<int, 8> custom_copy(custom_list);
+    ASSERT_TRUE(custom_copy == custom_list);
+    ASSERT_EQ(0, custom_copy.stats().tombstones);
+
+    custom_list.compact();
+    ASSERT_EQ(0, custom_list.stats().tombstones);
+    ASSERT_TRUE(custom_copy == custom_list);
+}
+
+TEST(ChunkListTest, LazyEraseAllocatorMoveTest) {
+    ChunkList<int, 4, CountingAllocator<int>> custom_list;
+    custom_list.enable_lazy_erase(1.0);
+    for (int custom_value = 0; custom_value < 10; custom_value++)
+        custom_list.push_back(custom_value);
+    custom_list.erase(++custom_list.begin());
+    custom_list.erase(custom_list.begin());
+    ASSERT_EQ(2, custom_list.stats().tombstones);
+
+    CountingAllocator<int> custom_other;
+    ChunkList<int, 4, CountingAllocator<int>> custom_moved(std::move(custom_list), custom_other);
+    ASSERT_EQ(8, custom_moved.size());
+    int custom_expected = 2;
+    for (int custom_value : custom_moved)
+        ASSERT_EQ(custom_expected++, custom_value);
+}
+
+TEST(ChunkListTest, LazyEraseCompactionTest) {
+    ChunkList<int, 8> custom_list;
+    custom_list.enable_lazy_erase(0.25);
+    for (int custom_value = 0; custom_value < 8; custom_value++) {
+        custom_list.push_back(custom_value);
+    }
+    auto custom_it = custom_list.begin();
+    custom_it = custom_list.erase(custom_it);
+    ++custom_it;
+    custom_it = custom_list.erase(custom_it);
+    ASSERT_EQ(2, custom_list.stats().tombstones);
+    ++custom_it;
+    custom_it = custom_list.erase(custom_it);
+    ASSERT_EQ(0, custom_list.stats().tombstones);
+    ASSERT_EQ(5, *custom_it);
+    custom_list.pop_back();
+    custom_list.pop_back();
+    custom_list.pop_back();
+    ASSERT_EQ(3, custom_list.back());
+    ASSERT_EQ(1, custom_list.front());
+    ASSERT_EQ(2, custom_list.size());
+}
+
+TEST(ChunkListTest, LazyEraseWideChunksTest) {
+    ChunkList<int, 100> custom_list;
+    custom_list.enable_lazy_erase(0.9);
+    for (int custom_value = 0; custom_value < 250; custom_value++) {
+        custom_list.push_back(custom_value);
+    }
+    auto custom_it = custom_list.begin();
+    while (custom_it != custom_list.end()) {
+        if (*custom_it % 2 == 1 || (*custom_it >= 100 && *custom_it < 200)) {
+            custom_it = custom_list.erase(custom_it);
+        } else {
+            ++custom_it;
+        }
+    }
+    ASSERT_EQ(75, custom_list.size());
+    ASSERT_EQ(2, custom_list.stats().chunk_count);
+    for (int custom_index = 0; custom_index < 50; custom_index++) {
+        ASSERT_EQ(2 * custom_index, custom_list[custom_index]);
+    }
+    for (int custom_index = 0; custom_index < 25; custom_index++) {
+        ASSERT_EQ(200 + 2 * custom_index, custom_list[50 + custom_index]);
+    }
+    ASSERT_EQ(248, custom_list.back());
+    auto custom_back = custom_list.begin();
+    for (int custom_index = 0; custom_index < 60; custom_index++) {
+        ++custom_back;
+    }
+    --custom_back;
+    ASSERT_EQ(218, *custom_back);
+    for (int custom_index = 0; custom_index < 11; custom_index++) {
+        --custom_back;
+    }
+    ASSERT_EQ(96, *custom_back);
+}
+
+struct CustomHeavy {
+    static inline int constructions = 0;
+    static inline int copies = 0;
+    static inline int moves = 0;
+    static inline int alive = 0;
+    static inline int copies_until_throw = 0; //The copy which brings it to 0 throws, 0 means never
+
+    std::string name;
+    std::vector<int> payload;
+
+    CustomHeavy() : CustomHeavy("", 0) {}
+
+    CustomHeavy(const char *custom_name, int custom_length) : name(custom_name), payload(custom_length, custom_length) {
+        constructions++;
+        alive++;
+    }
+
+    CustomHeavy(const CustomHeavy &other) : name(other.name), payload(other.payload) {
+        if (copies_until_throw != 0 && --copies_until_throw == 0)
+            throw std::runtime_error("Copy failed");
+        copies++;
+        alive++;
+    }
+
+    CustomHeavy(CustomHeavy &&other) noexcept : name(std::move(other.name)), payload(std::move(other.payload)) {
+        moves++;
+        alive++;
+    }
+
+    CustomHeavy &operator=(const CustomHeavy &) = default;
+
+    CustomHeavy &operator=(CustomHeavy &&) = default;
+
+    ~CustomHeavy() {
+        alive--;
+    }
+};
+
+TEST(ChunkListTest, IndexFingerTest) {
+    ChunkList<int, 8> custom_list;
+    for (int custom_value = 0; custom_value < 1000; custom_value++) {
+        custom_list.push_back(custom_value);
+    }
+#ifdef CHUNKLIST_ENABLE_COUNTERS
+    custom_list.reset_counters();
+#endif
+    long long custom_sum = 0;
+    for (int custom_index = 0; custom_index < 1000; custom_index++) {
+        custom_sum += custom_list[custom_index];
+    }
+    for (int custom_index = 999; custom_index >= 0; custom_index--) {
+        custom_sum += custom_list[custom_index];
+    }
+    ASSERT_EQ(999000, custom_sum);
+#ifdef CHUNKLIST_ENABLE_COUNTERS
+    ASSERT_EQ(123 + 124, custom_list.stats().counters.steps(ChunkListOperation::access));
+#endif
+
+    ASSERT_EQ(500, custom_list[500]);
+    auto custom_it = custom_list.begin();
+    for (int custom_index = 0; custom_index < 10; custom_index++) {
+        ++custom_it;
+    }
+    custom_list.insert(custom_it, -1);
+    ASSERT_EQ(499, custom_list[500]);
+    custom_list.pop_front();
+    custom_list.pop_front();
+    ASSERT_EQ(501, custom_list[500]);
+    ASSERT_EQ(-1, custom_list[8]);
+    custom_list.resize(600);
+    ASSERT_EQ(600, custom_list[599]);
+    ASSERT_THROW(custom_list.at(600), std::out_of_range);
+}
+
+TEST(ChunkListTest, EmplaceTest) {
+    {
+        ChunkList<CustomHeavy, 4> custom_list;
+        for (int custom_length = 0; custom_length < 6; custom_length++) {
+            CustomHeavy &custom_element = custom_list.emplace_back("back", custom_length);
+            ASSERT_EQ(custom_length, custom_element.payload.size());
+        }
+        ASSERT_EQ(6, CustomHeavy::constructions);
+        ASSERT_EQ(0, CustomHeavy::copies);
+        ASSERT_EQ(0, CustomHeavy::moves);
+
+        ASSERT_EQ("front", custom_list.emplace_front("front", 9).name);
+        ASSERT_EQ(7, CustomHeavy::constructions);
+        ASSERT_EQ(0, CustomHeavy::moves);
+
+        auto custom_it = custom_list.begin();
+        ++custom_it;
+        ++custom_it;
+        custom_it = custom_list.emplace(custom_it, "middle", 2);
+        ASSERT_EQ("middle", custom_it->name);
+        ASSERT_EQ(8, custom_list.size());
+        ASSERT_EQ(0, CustomHeavy::copies);
+
+        custom_list.insert(custom_list.cend(), CustomHeavy("moved", 1));
+        ASSERT_EQ(0, CustomHeavy::copies);
+        ASSERT_EQ("moved", custom_list.back().name);
+        custom_list.insert(custom_list.cbegin(), custom_list.back());
+        ASSERT_EQ(1, CustomHeavy::copies);
+        ASSERT_EQ("moved", custom_list.front().name);
+
+        std::vector<std::string> custom_names;
+        for (const CustomHeavy &custom_element : custom_list) {
+            custom_names.push_back(custom_element.name);
+        }
+        ASSERT_EQ((std::vector<std::string>{"moved", "front", "back", "middle", "back", "back", "back", "back", "back",
+                                            "moved"}), custom_names);
+
+        custom_list.resize(4);
+        ASSERT_EQ(4, CustomHeavy::alive);
+        int custom_copies = CustomHeavy::copies;
+        custom_list.resize(7, CustomHeavy("filler", 3));
+        ASSERT_EQ(custom_copies + 2, CustomHeavy::copies);
+        ASSERT_EQ("filler", custom_list.back().name);
+        custom_list.resize(8);
+        ASSERT_TRUE(custom_list.back().name.empty());
+        custom_list.erase(custom_list.begin());
+        custom_list.pop_back();
+        ASSERT_EQ(6, CustomHeavy::alive);
+    }
+    ASSERT_EQ(0, CustomHeavy::alive);
+}
+
+TEST(ChunkListTest, ThrowingConstructionTest) {
+    using CustomHeavyList = ChunkList<CustomHeavy, 4, CountingAllocator<CustomHeavy>>;
+    CountingAllocator<CustomHeavy> custom_allocator;
+    CustomHeavyList custom_list(custom_allocator);
+    for (int custom_length = 0; custom_length < 10; custom_length++) {
+        custom_list.emplace_back("element", custom_length);
+    }
+    int custom_alive = CustomHeavy::alive;
+    std::size_t custom_in_use = custom_allocator.stats().bytes_in_use;
+
+    CustomHeavy::copies_until_throw = 7;
+    ASSERT_THROW(CustomHeavyList custom_copy(custom_list), std::runtime_error);
+    ASSERT_EQ(custom_alive, CustomHeavy::alive);
+    ASSERT_EQ(custom_in_use, custom_allocator.stats().bytes_in_use);
+
+    CustomHeavy::copies_until_throw = 9;
+    ASSERT_THROW(CustomHeavyList custom_copy(custom_list, custom_allocator), std::runtime_error);
+    ASSERT_EQ(custom_alive, CustomHeavy::alive);
+    ASSERT_EQ(custom_in_use, custom_allocator.stats().bytes_in_use);
+    CustomHeavy::copies_until_throw = 0;
+
+    custom_allocator.fail_nth_allocation(3);
+    ASSERT_THROW(CustomHeavyList custom_copy(custom_list), std::bad_alloc);
+    ASSERT_EQ(custom_alive, CustomHeavy::alive);
+    ASSERT_EQ(custom_in_use, custom_allocator.stats().bytes_in_use);
+
+    custom_allocator.fail_nth_allocation(2);
+    ASSERT_THROW(CustomHeavyList(9, CustomHeavy("filler", 2), custom_allocator), std::bad_alloc);
+    ASSERT_EQ(custom_alive, CustomHeavy::alive);
+    ASSERT_EQ(custom_in_use, custom_allocator.stats().bytes_in_use);
+
+    CustomHeavy::copies_until_throw = 3;
+    ASSERT_THROW(CustomHeavyList({CustomHeavy("first", 1), CustomHeavy("second", 2), CustomHeavy("third", 3)},
+                                 custom_allocator), std::runtime_error);
+    ASSERT_EQ(custom_alive, CustomHeavy::alive);
+    ASSERT_EQ(custom_in_use, custom_allocator.stats().bytes_in_use);
+    CustomHeavy::copies_until_throw = 0;
+    ASSERT_EQ(10, CustomHeavyList(custom_list).size());
+}
+
+TEST(ChunkListTest, AssignReusesChunksTest) {
+    CountingAllocator<int> custom_allocator;
+    ChunkList<int, 8, CountingAllocator<int>> custom_list(40, 1, custom_allocator);
+    ASSERT_EQ(5, custom_allocator.stats().allocations);
+    custom_allocator.reset();
+
+    custom_list.assign(20, 7);
+    ASSERT_EQ(20, custom_list.size());
+    ASSERT_EQ(0, custom_allocator.stats().allocations);
+    ASSERT_EQ(2, custom_allocator.stats().deallocations);
+    for (int custom_value : custom_list) {
+        ASSERT_EQ(7, custom_value);
+    }
+
+    custom_list.assign(36, 3);
+    ASSERT_EQ(2, custom_allocator.stats().allocations);
+    ASSERT_EQ(36, custom_list.size());
+    ASSERT_EQ(3, custom_list[35]);
+    custom_list.push_back(4);
+    ASSERT_EQ(4, custom_list.back());
+
+    custom_list = {5, 6, 7};
+    ASSERT_EQ(3, custom_list.size());
+    ASSERT_EQ(6, custom_list[1]);
+    ASSERT_EQ(7, custom_list.back());
+    ASSERT_EQ(1, custom_list.stats().chunk_count);
+}
+
+TEST(ChunkListTest, ResizeWholeChunksTest) {
+    CountingAllocator<int> custom_allocator;
+    ChunkList<int, 8, CountingAllocator<int>> custom_list(custom_allocator);
+    custom_list.push_back(9);
+    custom_list.resize(30);
+    ASSERT_EQ(30, custom_list.size());
+    ASSERT_EQ(4, custom_allocator.stats().allocations);
+    ASSERT_EQ(9, custom_list.front());
+    ASSERT_EQ(0, custom_list[29]);
+    custom_list.resize(35, 2);
+    ASSERT_EQ(2, custom_list.back());
+    ASSERT_EQ(0, custom_list[29]);
+
+    custom_list.enable_lazy_erase();
+    custom_list.erase(custom_list.begin());
+    custom_list.resize(3);
+    ASSERT_EQ(3, custom_list.size());
+    ASSERT_EQ(1, custom_list.stats().chunk_count);
+    ASSERT_EQ(0, custom_list.back());
+    custom_list.resize(0);
+    ASSERT_TRUE(custom_list.empty());
+    custom_list.resize(2, 5);
+    ASSERT_EQ(5, custom_list.front());
+    ASSERT_EQ(5, custom_allocator.stats().allocations);
+    ASSERT_EQ(4, custom_allocator.stats().deallocations);
+
+    {
+        ChunkList<CustomHeavy, 4> custom_heavy_list;
+        int custom_alive = CustomHeavy::alive;
+        custom_heavy_list.resize(9, CustomHeavy("filled", 1));
+        custom_heavy_list.assign(6, CustomHeavy("assigned", 2));
+        ASSERT_EQ(custom_alive + 6, CustomHeavy::alive);
+        ASSERT_EQ("assigned", custom_heavy_list[5].name);
+        custom_heavy_list.resize(2);
+        ASSERT_EQ(custom_alive + 2, CustomHeavy::alive);
+    }
+}
+
+TEST(ChunkListTest, ZoneMapTest) {
+    ChunkList<int, 4> custom_list;
+    for (int i = 0; i < 20; i++)
+        custom_list.push_back(i);
+    ASSERT_THROW(custom_list.sum(0, 20), std::logic_error);
+    custom_list.enable_zone_maps();
+    ASSERT_EQ(190, custom_list.sum(0, 20));
+    ASSERT_EQ(133, custom_list.sum(3, 17));
+    ASSERT_EQ(0, custom_list.sum(7, 7));
+    ASSERT_EQ(3, custom_list.min(3, 17));
+    ASSERT_EQ(16, custom_list.max(3, 17));
+    ASSERT_EQ(8, custom_list.count_if_in_range(5, 12));
+    ASSERT_THROW(custom_list.min(4, 4), std::out_of_range);
+    ASSERT_THROW(custom_list.sum(0, 21), std::out_of_range);
+
+    auto custom_position = custom_list.begin();
+    for (int i = 0; i < 6; i++)
+        ++custom_position;
+    custom_list.insert(custom_position, 100);
+    ASSERT_EQ(100, custom_list.max(0, 21));
+    ASSERT_EQ(290, custom_list.sum(0, 21));
+    custom_list.pop_front();
+    custom_list.pop_back();
+    custom_list.set(4, -7);
+    ASSERT_EQ(-7, custom_list.min(0, 19));
+    ASSERT_EQ(1 + 2 + 3 + 4 - 7 + 100 + 6 + 7, custom_list.sum(0, 8));
+    ASSERT_EQ(2, custom_list.count_if_in_range(50, 150) + custom_list.count_if_in_range(-7, -7));
+
+    std::vector<int> custom_reference;
+    for (int value : custom_list)
+        custom_reference.push_back(value);
+    std::mt19937 custom_random(5);
+    custom_list.enable_lazy_erase();
+    for (int step = 0; step < 3000; step++) {
+        int custom_roll = custom_random() % 6;
+        int custom_value = static_cast<int>(custom_random() % 1000) - 500;
+        if (custom_roll == 0 || custom_reference.size() < 4) {
+            custom_list.push_back(custom_value);
+            custom_reference.push_back(custom_value);
+        } else if (custom_roll == 1) {
+            std::size_t custom_index = custom_random() % custom_reference.size();
+            custom_list.set(custom_index, custom_value);
+            custom_reference[custom_index] = custom_value;
+        } else if (custom_roll == 2) {
+            std::size_t custom_index = custom_random() % custom_reference.size();
+            auto custom_target = custom_list.begin();
+            for (std::size_t i = 0; i < custom_index; i++)
+                ++custom_target;
+            custom_list.erase(custom_target);
+            custom_reference.erase(custom_reference.begin() + custom_index);
+        } else if (custom_roll == 3) {
+            std::size_t custom_index = custom_random() % custom_reference.size();
+            auto custom_target = custom_list.begin();
+            for (std::size_t i = 0; i < custom_index; i++)
+                ++custom_target;
+            custom_list.insert(custom_target, custom_value);
+            custom_reference.insert(custom_reference.begin() + custom_index, custom_value);
+        } else if (custom_roll == 4 && step % 100 == 4) {
+            custom_list.sort();
+            std::sort(custom_reference.begin(), custom_reference.end());
+        } else {
+            std::size_t custom_first = custom_random() % custom_reference.size();
+            std::size_t custom_last = custom_first + 1 + custom_random() % (custom_reference.size() - custom_first);
+            ASSERT_EQ(std::accumulate(custom_reference.begin() + custom_first, custom_reference.begin() + custom_last, 0LL),
+                      custom_list.sum(custom_first, custom_last));
+            ASSERT_EQ(*std::min_element(custom_reference.begin() + custom_first, custom_reference.begin() + custom_last),
+                      custom_list.min(custom_first, custom_last));
+            ASSERT_EQ(*std::max_element(custom_reference.begin() + custom_first, custom_reference.begin() + custom_last),
+                      custom_list.max(custom_first, custom_last));
+            ASSERT_EQ(std::count_if(custom_reference.begin(), custom_reference.end(),
+                                    [custom_value](int value) { return value >= custom_value && value <= custom_value + 200; }),
+                      custom_list.count_if_in_range(custom_value, custom_value + 200));
+        }
+    }
+}
+
+TEST(ChunkListTest, MergeIntoZoneMapsTest) {
+    ChunkList<int, 3> first_list;
+    ChunkList<int, 3> second_list;
+    first_list.enable_zone_maps();
+    for (int custom_value = 0; custom_value < 10; custom_value++) {
+        first_list.push_back(2 * custom_value);
+        second_list.push_back(2 * custom_value + 1);
+    }
+    first_list.merge(std::move(second_list));
+    ASSERT_EQ(190, first_list.sum(0, 20));
+    ASSERT_EQ(5, first_list.min(5, 17));
+    ASSERT_EQ(16, first_list.max(5, 17));
+    ASSERT_EQ(6, first_list.count_if_in_range(3, 8));
+    first_list.push_back(40);
+    ASSERT_EQ(40, first_list.max(0, 21));
+}
+
+TEST(ChunkListTest, SharedReadingTest) {
+    ChunkList<int, 4> custom_list;
+    for (int i = 0; i < 6; i++)
+        custom_list.push_back(i);
+    custom_list.enable_shared_reading();
+    ASSERT_TRUE(custom_list.is_lazy_erase());
+    ChunkListSnapshot<int> custom_snapshot = custom_list.snapshot();
+
+    for (int i = 6; i < 10; i++)
+        custom_list.push_back(i);
+    for (int i = 0; i < 5; i++)
+        custom_list.pop_front();
+    ASSERT_EQ(5, custom_list.size());
+    ASSERT_EQ(5, custom_list.front());
+    ASSERT_EQ(7, custom_list[2]);
+    ASSERT_EQ(1, custom_list.stats().retired_chunks);
+
+    std::vector<int> custom_seen;
+    custom_snapshot.for_each([&custom_seen](int value) { custom_seen.push_back(value); });
+    ASSERT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5}), custom_seen);
+    ASSERT_EQ(6, custom_snapshot.size());
+
+    custom_snapshot = ChunkListSnapshot<int>();
+    custom_list.push_back(10);
+    ASSERT_EQ(0, custom_list.stats().retired_chunks);
+    custom_snapshot = custom_list.snapshot();
+    custom_seen.clear();
+    custom_snapshot.for_each([&custom_seen](int value) { custom_seen.push_back(value); });
+    ASSERT_EQ(std::vector<int>({5, 6, 7, 8, 9, 10}), custom_seen);
+
+    ASSERT_THROW(custom_list.enable_ring_mode(8), std::logic_error);
+    custom_list.clear();
+    ASSERT_EQ(2, custom_list.stats().retired_chunks);
+    ASSERT_EQ(6, custom_snapshot.size());
+    custom_snapshot = ChunkListSnapshot<int>();
+    custom_list.disable_shared_reading();
+    ASSERT_EQ(0, custom_list.stats().retired_chunks);
+    ASSERT_THROW(custom_list.snapshot(), std::logic_error);
+}
+
+TEST(ChunkListTest, SharedReadingThreadsTest) {
+    ChunkList<long, 16> custom_list;
+    custom_list.enable_shared_reading();
+    std::atomic<bool> custom_done{false};
+    std::atomic<int> custom_errors{0};
+    auto custom_reader = [&]() {
+        while (!custom_done.load()) {
+            ChunkListSnapshot<long> custom_snapshot = custom_list.snapshot();
+            long custom_previous = -1;
+            std::size_t custom_count = 0;
+            custom_snapshot.for_each([&](long value) {
+                if (custom_previous != -1 && value != custom_previous + 1)
+                    custom_errors++;
+                custom_previous = value;
+                custom_count++;
+            });
+            if (custom_count != custom_snapshot.size())
+                custom_errors++;
+        }
+    };
+    std::thread custom_first(custom_reader);
+    std::thread custom_second(custom_reader);
+    for (long i = 0; i < 200000; i++) {
+        custom_list.push_back(i);
+        if (custom_list.size() > 500)
+            custom_list.pop_front();
+    }
+    custom_done = true;
+    custom_first.join();
+    custom_second.join();
+    ASSERT_EQ(0, custom_errors.load());
+    ASSERT_EQ(500, custom_list.size());
+    ASSERT_EQ(199500, custom_list.front());
+}
+
+#ifdef CHUNKLIST_HAS_READV
+TEST(ChunkListTest, AppendFromFdTest) {
+    int custom_pipe[2];
+    ASSERT_EQ(0, pipe(custom_pipe));
+    ChunkList<std::uint32_t, 4> custom_list;
+    custom_list.push_back(100);
+    std::uint32_t custom_values[12];
+    for (std::uint32_t custom_index = 0; custom_index < 12; custom_index++) {
+        custom_values[custom_index] = custom_index;
+    }
+    const char *custom_bytes = reinterpret_cast<const char *>(custom_values);
+
+    ASSERT_EQ(10 * sizeof(std::uint32_t) + 2, write(custom_pipe[1], custom_bytes, 10 * sizeof(std::uint32_t) + 2));
+    ASSERT_EQ(10, custom_list.append_from_fd(custom_pipe[0], 64));
+    ASSERT_EQ(11, custom_list.size());
+    ASSERT_EQ(100, custom_list.front());
+    ASSERT_EQ(9, custom_list.back());
+    ASSERT_EQ(3, custom_list.stats().chunk_count);
+
+    ASSERT_EQ(6, write(custom_pipe[1], custom_bytes + 10 * sizeof(std::uint32_t) + 2, 6));
+    ASSERT_EQ(1, custom_list.append_from_fd(custom_pipe[0], 1));
+    ASSERT_EQ(10, custom_list.back());
+    ASSERT_EQ(1, custom_list.append_from_fd(custom_pipe[0], 64));
+    ASSERT_EQ(11, custom_list.back());
+    for (std::uint32_t custom_index = 0; custom_index < 12; custom_index++) {
+        ASSERT_EQ(custom_index, custom_list[custom_index + 1]);
+    }
+
+    ASSERT_EQ(2, write(custom_pipe[1], custom_bytes, 2));
+    close(custom_pipe[1]);
+    ASSERT_THROW(custom_list.append_from_fd(custom_pipe[0], 64), std::runtime_error);
+    ASSERT_EQ(0, custom_list.append_from_fd(custom_pipe[0], 64));
+    close(custom_pipe[0]);
+    ASSERT_EQ(13, custom_list.size());
+    ASSERT_EQ(4, custom_list.stats().chunk_count);
+
+    ASSERT_EQ(0, pipe(custom_pipe));
+    CountingAllocator<std::uint32_t> custom_allocator;
+    ChunkList<std::uint32_t, 4, CountingAllocator<std::uint32_t>> custom_loader(custom_allocator);
+    ASSERT_EQ(10 * sizeof(std::uint32_t), write(custom_pipe[1], custom_bytes, 10 * sizeof(std::uint32_t)));
+    ASSERT_EQ(10, custom_loader.append_from_fd(custom_pipe[0], SIZE_MAX));
+    ASSERT_EQ(3, custom_allocator.stats().allocations);
+    ASSERT_EQ(0, custom_allocator.stats().deallocations);
+    ASSERT_EQ(9, custom_loader.back());
+    close(custom_pipe[1]);
+    ASSERT_EQ(0, custom_loader.append_from_fd(custom_pipe[0], SIZE_MAX));
+    ASSERT_LE(custom_allocator.stats().allocations, 4);
+    close(custom_pipe[0]);
+}
+#endif
+
+TEST(ChunkListTest, DrainAndAdoptTest) {
+    CountingAllocator<int> custom_allocator;
+    ChunkList<int, 4, CountingAllocator<int>> custom_producer(custom_allocator);
+    ChunkList<int, 4, CountingAllocator<int>> custom_consumer(custom_allocator);
+    for (int custom_value = 0; custom_value < 10; custom_value++) {
+        custom_producer.push_back(custom_value);
+    }
+    custom_allocator.reset();
+    auto custom_batch = custom_producer.drain_front_chunk();
+    ASSERT_EQ(4, custom_batch.size());
+    ASSERT_EQ(6, custom_producer.size());
+    ASSERT_EQ(4, custom_producer.front());
+    ASSERT_EQ(3, custom_batch[3]);
+    int *custom_data = custom_batch.data();
+    custom_consumer.adopt_back(std::move(custom_batch));
+    ASSERT_EQ(nullptr, custom_batch.data());
+    custom_consumer.adopt_back(custom_producer.drain_front_chunk());
+    custom_consumer.adopt_back(custom_producer.drain_front_chunk());
+    ASSERT_TRUE(custom_producer.empty());
+    ASSERT_EQ(0, custom_producer.drain_front_chunk().size());
+    ASSERT_EQ(0, custom_allocator.stats().allocations);
+    ASSERT_EQ(1, custom_allocator.stats().deallocations);
+    ASSERT_EQ(10, custom_consumer.size());
+    ASSERT_EQ(custom_data, &custom_consumer.front());
+    int custom_expected = 0;
+    for (int custom_value : custom_consumer) {
+        ASSERT_EQ(custom_expected++, custom_value);
+    }
+    custom_consumer.push_back(10);
+    ASSERT_EQ(10, custom_consumer.back());
+
+    auto custom_fresh = custom_consumer.make_buffer();
+    custom_fresh[0] = 11;
+    custom_fresh.set_size(1);
+    custom_consumer.adopt_back(std::move(custom_fresh));
+    ASSERT_EQ(12, custom_consumer.size());
+    ASSERT_EQ(11, custom_consumer.back());
+
+    int custom_released = 0;
+    ChunkBuffer<int, CountingAllocator<int>> custom_foreign(new int[2]{12, 13}, 2, 2, [&custom_released](int *custom_pointer, std::size_t) {
+        custom_released++;
+        delete[] custom_pointer;
+    });
+    custom_consumer.adopt_back(std::move(custom_foreign));
+    ASSERT_EQ(1, custom_released);
+    ASSERT_EQ(14, custom_consumer.size());
+    ASSERT_EQ(13, custom_consumer.back());
+    ASSERT_EQ(12, custom_consumer[12]);
+}
+
+TEST(ChunkListTest, RingModeTest) {
+    CountingAllocator<int> custom_allocator;
+    ChunkList<int, 4, CountingAllocator<int>> custom_window(custom_allocator);
+    custom_window.enable_ring_mode(10);
+    for (int custom_value = 0; custom_value < 100; custom_value++) {
+        custom_window.push_back(custom_value);
+        ASSERT_EQ(std::min(custom_value + 1, 10), custom_window.size());
+        ASSERT_EQ(custom_value, custom_window.back());
+        ASSERT_EQ(std::max(custom_value - 9, 0), custom_window.front());
+    }
+    ASSERT_EQ(4, custom_allocator.stats().allocations);
+    ASSERT_EQ(0, custom_allocator.stats().deallocations);
+    ASSERT_EQ(10, custom_window.size());
+    ASSERT_EQ(90, custom_window.front());
+    ASSERT_EQ(96, custom_window.at(6));
+    ASSERT_THROW(custom_window.at(10), std::out_of_range);
+    int custom_expected = 90;
+    for (int custom_value : custom_window) {
+        ASSERT_EQ(custom_expected++, custom_value);
+    }
+    ASSERT_EQ(100, custom_expected);
+    ASSERT_THROW(custom_window.disable_lazy_erase(), std::logic_error);
+
+    custom_window.enable_ring_mode(5);
+    ASSERT_EQ(5, custom_window.size());
+    ASSERT_EQ(95, custom_window.front());
+    custom_window.pop_back();
+    for (int custom_value = 99; custom_value <= 104; custom_value++) {
+        custom_window.push_back(custom_value);
+    }
+    ASSERT_EQ(5, custom_window.size());
+    ASSERT_EQ(100, custom_window[0]);
+    ASSERT_EQ(104, custom_window[4]);
+    ASSERT_EQ(3, custom_allocator.stats().allocations - custom_allocator.stats().deallocations);
+}
+
+TEST(ChunkListTest, RingModeSelfPushTest) {
+    ChunkList<std::string, 4> custom_window;
+    custom_window.enable_ring_mode(4);
+    for (int custom_index = 0; custom_index < 8; custom_index++) {
+        custom_window.push_back("event number " + std::to_string(custom_index));
+    }
+    for (int custom_index = 0; custom_index < 9; custom_index++) {
+        std::string custom_expected = custom_window.front();
+        custom_window.push_back(custom_window.front());
+        ASSERT_EQ(custom_expected, custom_window.back());
+        custom_expected = custom_window[0];
+        custom_window.emplace_back(custom_window[0]);
+        ASSERT_EQ(custom_expected, custom_window.back());
+        ASSERT_EQ(4, custom_window.size());
+    }
+}
+
+TEST(ChunkListTest, MergeIntoHandlesTest) {
+    ChunkList<int, 3> first_list;
+    ChunkList<int, 3> second_list;
+    first_list.enable_handles();
+    for (int custom_value = 0; custom_value < 10; custom_value++) {
+        first_list.push_back(2 * custom_value);
+        second_list.push_back(2 * custom_value + 1);
+    }
+    ChunkListHandle custom_stale = first_list.handle(first_list.begin());
+    first_list.merge(std::move(second_list));
+    ASSERT_EQ(nullptr, first_list.get(custom_stale));
+
+    std::vector<ChunkListHandle> custom_handles;
+    for (auto custom_iter = first_list.begin(); custom_iter != first_list.end(); ++custom_iter)
+        custom_handles.push_back(first_list.handle(custom_iter));
+    first_list.erase(first_list.begin());
+    first_list.push_front(-1);
+    for (int custom_index = 1; custom_index < 20; custom_index++) {
+        ASSERT_NE(nullptr, first_list.get(custom_handles[custom_index]));
+        ASSERT_EQ(custom_index, *first_list.get(custom_handles[custom_index]));
+    }
+    ASSERT_EQ(nullptr, first_list.get(custom_handles[0]));
+}
+
+TEST(ChunkListTest, HandlesTest) {
+    ChunkList<int, 4> custom_list;
+    for (int custom_index = 0; custom_index < 20; custom_index++) {
+        custom_list.push_back(custom_index * 10);
+    }
+    ASSERT_THROW(custom_list.handle(custom_list.begin()), std::runtime_error);
+    custom_list.enable_handles();
+    ChunkListHandle custom_handles[20];
+    for (int custom_index = 0; custom_index < 20; custom_index++) {
+        auto custom_iter = custom_list.begin();
+        for (int custom_step = 0; custom_step < custom_index; custom_step++) {
+            ++custom_iter;
+        }
+        custom_handles[custom_index] = custom_list.handle(custom_iter);
+    }
+    ASSERT_TRUE(custom_handles[7] == custom_list.handle(custom_list.find(custom_handles[7])));
+
+    custom_list.erase(custom_list.find(custom_handles[5]));
+    custom_list.erase(custom_list.begin());
+    custom_list.pop_back();
+    ASSERT_EQ(nullptr, custom_list.get(custom_handles[0]));
+    ASSERT_EQ(nullptr, custom_list.get(custom_handles[5]));
+    ASSERT_EQ(nullptr, custom_list.get(custom_handles[19]));
+    for (int custom_index : {1, 2, 3, 4, 6, 7, 18}) {
+        ASSERT_EQ(custom_index * 10, *custom_list.get(custom_handles[custom_index]));
+    }
+
+    custom_list.enable_lazy_erase(0.5);
+    custom_list.erase(custom_list.find(custom_handles[9]));
+    custom_list.erase(custom_list.find(custom_handles[10]));
+    custom_list.erase(custom_list.find(custom_handles[13]));
+    custom_list.compact();
+    for (int custom_index : {8, 11, 12, 14, 15, 18}) {
+        ASSERT_EQ(custom_index * 10, *custom_list.get(custom_handles[custom_index]));
+    }
+    ASSERT_EQ(nullptr, custom_list.get(custom_handles[10]));
+
+    ASSERT_TRUE(custom_handles[1] == custom_list.handle(custom_list.begin()));
+    custom_list.push_back(1000);
+    auto custom_last = custom_list.begin();
+    for (std::size_t custom_step = 1; custom_step < custom_list.size(); custom_step++) {
+        ++custom_last;
+    }
+    ChunkListHandle custom_reused = custom_list.handle(custom_last);
+    ASSERT_EQ(13, custom_reused.index);
+    ASSERT_EQ(nullptr, custom_list.get(custom_handles[13]));
+    ASSERT_EQ(1000, *custom_list.get(custom_reused));
+    custom_list.pop_back();
+
+    custom_list.disable_lazy_erase();
+    custom_list.enable_sorted_mode();
+    for (int custom_value : {11, 12, 13, 14, 15, 16}) {
+        custom_list.insert_sorted(custom_value);
+    }
+    for (int custom_index : {1, 2, 3, 4, 6, 7, 8, 11, 12, 14, 15, 18}) {
+        ASSERT_EQ(custom_index * 10, *custom_list.get(custom_handles[custom_index]));
+    }
+    ASSERT_EQ(170, *(++custom_list.find(custom_handles[16])));
+
+    ChunkList<int, 4> custom_moved(std::move(custom_list));
+    ASSERT_EQ(40, *custom_moved.get(custom_handles[4]));
+    custom_moved.sort();
+    ASSERT_EQ(nullptr, custom_moved.get(custom_handles[4]));
+}
+
+TEST(ChunkListTest, HugePageAllocatorTest) {
+    HugePageAllocator<long long> custom_allocator;
+    long long *custom_first = custom_allocator.allocate(100);
+    long long *custom_second = custom_allocator.allocate(100);
+    ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(custom_first) % 4096);
+    ASSERT_EQ(4096, reinterpret_cast<char *>(custom_second) - reinterpret_cast<char *>(custom_first));
+    custom_allocator.deallocate(custom_first, 100);
+    ASSERT_EQ(custom_first, custom_allocator.allocate(100));
+    ASSERT_EQ(8192, custom_allocator.stats().bytes_in_use);
+    long long *custom_large = custom_allocator.allocate(300000);
+    ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(custom_large) % (2 << 20));
+    ASSERT_EQ(2, custom_allocator.stats().regions);
+
+    ChunkList<long long, 32768, HugePageAllocator<long long>> custom_list(custom_allocator);
+    for (long long custom_index = 0; custom_index < 300000; custom_index++) {
+        custom_list.push_back(custom_index);
+    }
+    ASSERT_EQ(123456, custom_list[123456]);
+    ASSERT_EQ(3, custom_allocator.stats().regions);
+    custom_list.clear();
+    ASSERT_EQ(8192 + 300000 * 8 / 4096 * 4096 + 4096, custom_allocator.stats().bytes_in_use);
+
+    custom_allocator.deallocate(custom_large, 300000);
+    ASSERT_EQ(2, custom_allocator.stats().regions);
+    ASSERT_EQ(2 * (2 << 20), custom_allocator.stats().reserved_bytes);
+    ASSERT_EQ(8192, custom_allocator.stats().bytes_in_use);
+    long long *custom_larger = custom_allocator.allocate(600000);
+    ASSERT_EQ(3, custom_allocator.stats().regions);
+    ASSERT_EQ(2 * (2 << 20) + 3 * (2 << 20), custom_allocator.stats().reserved_bytes);
+    custom_larger[599999] = 7;
+    custom_allocator.deallocate(custom_larger, 600000);
+    ASSERT_EQ(2, custom_allocator.stats().regions);
+}
+
+TEST(ChunkListTest, HugePageRegionTailTest) {
+    HugePageAllocator<char> custom_allocator;
+    char *custom_first = custom_allocator.allocate(1536 << 10);
+    char *custom_second = custom_allocator.allocate(1 << 20);
+    ASSERT_EQ(2, custom_allocator.stats().regions);
+    ASSERT_EQ(custom_first + (1536 << 10), custom_allocator.allocate(256 << 10));
+    ASSERT_EQ(custom_first + (1792 << 10), custom_allocator.allocate(128 << 10));
+    ASSERT_EQ(custom_first + (1920 << 10), custom_allocator.allocate(128 << 10));
+    ASSERT_EQ(2, custom_allocator.stats().regions);
+
+    custom_allocator.deallocate(custom_second, 1 << 20);
+    ASSERT_EQ(custom_second, custom_allocator.allocate(4096));
+    ASSERT_EQ(custom_second + 4096, custom_allocator.allocate(4096));
+    ASSERT_EQ(custom_second + 8192, custom_allocator.allocate(8192));
+    ASSERT_EQ(2, custom_allocator.stats().regions);
+    ASSERT_LE(custom_allocator.stats().huge_page_regions, custom_allocator.stats().regions);
+}
+
+TEST(ChunkListTest, BoolMaskTest) {
+    ChunkList<bool, 200> custom_mask(1000, false);
+    ASSERT_EQ(1000, custom_mask.size());
+    ASSERT_EQ(0, custom_mask.count(true));
+    custom_mask[3] = true;
+    custom_mask.fill(190, 450, true);
+    ASSERT_EQ(261, custom_mask.count(true));
+    ASSERT_EQ(739, custom_mask.count(false));
+    ASSERT_EQ(3, custom_mask.find(true));
+    ASSERT_EQ(190, custom_mask.find(true, 4));
+    ASSERT_EQ(450, custom_mask.find(false, 190));
+    ASSERT_EQ(1000, custom_mask.find(true, 450));
+    ASSERT_TRUE(custom_mask.at(449));
+    ASSERT_FALSE(custom_mask.at(450));
+
+    custom_mask.fill(0, 1000, false);
+    custom_mask[999] = custom_mask[998] = true;
+    ASSERT_EQ(2, custom_mask.count(true));
+    custom_mask.resize(999);
+    ASSERT_EQ(1, custom_mask.count(true));
+    custom_mask.resize(1100, true);
+    ASSERT_EQ(102, custom_mask.count(true));
+    ASSERT_FALSE(custom_mask[997]);
+    ASSERT_EQ(6, custom_mask.stats().chunk_count);
+    ASSERT_EQ(138, custom_mask.stats().live_bytes);
+
+    ChunkList<bool, 200> custom_copy = custom_mask;
+    ASSERT_TRUE(custom_copy == custom_mask);
+    custom_copy.pop_back();
+    custom_copy.push_back(false);
+    ASSERT_TRUE(custom_copy != custom_mask);
+    std::size_t custom_set = 0;
+    for (bool custom_value : custom_copy) {
+        custom_set += custom_value;
+    }
+    ASSERT_EQ(101, custom_set);
+}
+
+TEST(ChunkListTest, BoolMaskEditTest) {
+    ChunkList<bool, 100> custom_mask = {true, false, true};
+    std::vector<bool> custom_reference = {true, false, true};
+    std::mt19937 custom_random(7);
+    for (int custom_step = 0; custom_step < 3000; custom_step++) {
+        std::size_t custom_index = custom_random() % (custom_reference.size() + 1);
+        bool custom_value = custom_random() % 3 == 0;
+        switch (custom_random() % 6) {
+            case 0:
+                custom_mask.insert(custom_mask.cbegin() + custom_index, custom_value);
+                custom_reference.insert(custom_reference.begin() + custom_index, custom_value);
+                break;
+            case 1:
+                if (custom_index < custom_reference.size()) {
+                    custom_mask.erase(custom_mask.cbegin() + custom_index);
+                    custom_reference.erase(custom_reference.begin() + custom_index);
+                }
+                break;
+            case 2:
+                custom_mask.push_front(custom_value);
+                custom_reference.insert(custom_reference.begin(), custom_value);
+                break;
+            case 3:
+                if (!custom_reference.empty()) {
+                    custom_mask.pop_front();
+                    custom_reference.erase(custom_reference.begin());
+                }
+                break;
+            default:
+                custom_mask.emplace_back(custom_value);
+                custom_reference.push_back(custom_value);
+        }
+    }
+    ASSERT_EQ(custom_reference.size(), custom_mask.size());
+    ASSERT_TRUE(std::equal(custom_reference.begin(), custom_reference.end(), custom_mask.begin()));
+    ASSERT_EQ(std::count(custom_reference.begin(), custom_reference.end(), true), custom_mask.count(true));
+    ASSERT_EQ(custom_reference.size(), static_cast<std::size_t>(custom_mask.end() - custom_mask.begin()));
+    ASSERT_EQ(custom_reference[150], custom_mask.begin()[150]);
+    ASSERT_EQ(custom_reference[150], *(custom_mask.cend() - (custom_reference.size() - 150)));
+
+    custom_mask.erase(custom_mask.cbegin() + 10, custom_mask.cbegin() + 300);
+    custom_reference.erase(custom_reference.begin() + 10, custom_reference.begin() + 300);
+    custom_mask.insert(custom_mask.cbegin() + 5, 3, true);
+    custom_reference.insert(custom_reference.begin() + 5, 3, true);
+    ASSERT_TRUE(std::equal(custom_reference.begin(), custom_reference.end(), custom_mask.begin()));
+    ASSERT_THROW(custom_mask.insert(custom_mask.cend() + 1, true), std::out_of_range);
+
+    ChunkList<PackedUint<3>, 50> custom_tags(120, 5);
+    custom_tags.insert(custom_tags.cbegin() + 30, {1, 2, 3});
+    custom_tags.erase(custom_tags.cbegin());
+    ASSERT_EQ(122, custom_tags.size());
+    ASSERT_EQ(1, custom_tags[29]);
+    ASSERT_EQ(3, custom_tags[31]);
+    ASSERT_EQ(5, custom_tags[32]);
+    ASSERT_EQ(5, custom_tags.back());
+    ASSERT_EQ(119, custom_tags.count(5));
+    ChunkList<PackedUint<3>, 50> custom_smaller = custom_tags;
+    custom_smaller[29] = 0;
+    ASSERT_TRUE(custom_smaller < custom_tags);
+}
+
+TEST(ChunkListTest, PackedUintTest) {
+    ChunkList<PackedUint<3>, 50> custom_tags;
+    for (int custom_index = 0; custom_index < 300; custom_index++) {
+        custom_tags.push_back(custom_index % 7);
+    }
+    ASSERT_EQ(42, custom_tags.count(6));
+    ASSERT_EQ(43, custom_tags.count(0));
+    ASSERT_EQ(5, custom_tags[5]);
+    ASSERT_EQ(20, custom_tags.find(6, 14));
+    custom_tags[20] = 9;
+    ASSERT_EQ(1, custom_tags[20]);
+    custom_tags.fill(40, 100, 0);
+    ASSERT_EQ(94, custom_tags.count(0));
+    while (!custom_tags.empty()) {
+        custom_tags.pop_back();
+    }
+    ASSERT_EQ(0, custom_tags.stats().chunk_count);
+}
+
+TEST(ChunkedSoATest, RowAccessTest) {
+    ChunkedSoA<8, long long, double, int> custom_ticks;
+    for (int custom_index = 0; custom_index < 20; custom_index++) {
+        custom_ticks.push_back(1000 + custom_index, custom_index * 0.5, custom_index % 3);
+    }
+    ASSERT_EQ(20, custom_ticks.size());
+    ASSERT_EQ(1013, custom_ticks[13].get<0>());
+    ASSERT_EQ(6.5, custom_ticks[13].get<1>());
+    custom_ticks[13] = std::make_tuple(7LL, 7.0, 7);
+    std::tuple<long long, double, int> custom_row = custom_ticks[13];
+    ASSERT_EQ(std::make_tuple(7LL, 7.0, 7), custom_row);
+    ASSERT_THROW(custom_ticks.at(20), std::out_of_range);
+
+    for (int custom_index = 0; custom_index < 12; custom_index++) {
+        custom_ticks.pop_back();
+    }
+    ASSERT_EQ(1, custom_ticks.stats().chunk_count);
+    ChunkListStats custom_stats = custom_ticks.stats();
+    ASSERT_EQ(8 * (sizeof(long long) + sizeof(double) + sizeof(int)), custom_stats.live_bytes);
+    ASSERT_EQ(0, custom_stats.slack_bytes);
+    ASSERT_EQ(1, custom_stats.fill_histogram[10]);
+    custom_ticks.push_back(std::make_tuple(1LL, 2.0, 3));
+    ASSERT_EQ(1LL, custom_ticks[8].get<0>());
+    ASSERT_EQ(2, custom_ticks.stats().chunk_count);
+    ASSERT_EQ(1, custom_ticks.stats().fill_histogram[1]);
+    ASSERT_EQ(7 * (sizeof(long long) + sizeof(double) + sizeof(int)), custom_ticks.stats().slack_bytes);
+}
+
+TEST(ChunkedSoATest, ColumnScanTest) {
+    ChunkedSoA<16, long long, double> custom_ticks;
+    for (int custom_index = 0; custom_index < 100; custom_index++) {
+        custom_ticks.push_back(custom_index, 1.5);
+    }
+    long long custom_sum = 0;
+    std::size_t custom_segments = 0;
+    for (auto custom_segment : custom_ticks.column<0>()) {
+        for (long long custom_value : custom_segment) {
+            custom_sum += custom_value;
+        }
+        custom_segments++;
+    }
+    ASSERT_EQ(99 * 100 / 2, custom_sum);
+    ASSERT_EQ(7, custom_segments);
+
+    for (auto custom_segment : custom_ticks.column<1>()) {
+        for (double &custom_value : custom_segment)
+            custom_value = 1.5;
+    }
+    const auto &custom_view = custom_ticks;
+    static_assert(std::is_same_v<const double *, decltype((*custom_view.column<1>().begin()).begin())>);
+
+    auto custom_copy = custom_ticks;
+    custom_ticks.clear();
+    ASSERT_TRUE(custom_ticks.column<1>().begin() == custom_ticks.column<1>().end());
+    double custom_total = 0;
+    for (auto custom_segment : custom_copy.column<1>()) {
+        for (double custom_value : custom_segment) {
+            custom_total += custom_value;
+        }
+    }
+    ASSERT_EQ(150.0, custom_total);
+}
+
+TEST(CompressedChunkListTest, TimestampsTest) {
+    CompressedChunkList<long long, 64> custom_history(2, 2);
+    for (long long custom_index = 0; custom_index < 10000; custom_index++) {
+        custom_history.push_back(1700000000000LL + custom_index * 1000 + custom_index % 7);
+    }
+    ASSERT_EQ(10000, custom_history.size());
+    ASSERT_EQ(1700000000000LL + 5000 * 1000 + 5000 % 7, custom_history[5000]);
+    ASSERT_EQ(1700000000000LL + 9999 * 1000 + 9999 % 7, custom_history.back());
+    ChunkListStats custom_stats = custom_history.stats();
+    ASSERT_EQ(10000 / 64 - 2, custom_stats.compressed_chunks);
+    ASSERT_GT(custom_stats.compression_ratio(), 4.0);
+    ASSERT_EQ(1, custom_stats.chunk_decodes);
+
+    custom_history.set(10, -5);
+    for (long long custom_index = 1000; custom_index < 2000; custom_index += 64) {
+        custom_history.at(custom_index);
+    }
+    ASSERT_EQ(-5, custom_history.at(10));
+    std::size_t custom_count = 0;
+    custom_history.for_each([&custom_count](long long) { custom_count++; });
+    ASSERT_EQ(10000, custom_count);
+
+    while (custom_history.size() > 100) {
+        custom_history.pop_back();
+    }
+    ASSERT_EQ(1700000000000LL + 99 * 1000 + 99 % 7, custom_history.back());
+    ASSERT_EQ(-5, custom_history[10]);
+    ASSERT_THROW(custom_history.at(100), std::out_of_range);
+}
+
+TEST(CompressedChunkListTest, SignedCountersTest) {
+    CompressedChunkList<int, 16> custom_counters(0, 1);
+    custom_counters.push_back(2147483647);
+    custom_counters.push_back(-2147483647 - 1);
+    for (int custom_index = 0; custom_index < 160; custom_index++) {
+        custom_counters.push_back(custom_index % 2 == 0 ? -custom_index % 5 : custom_index % 3);
+    }
+    ASSERT_EQ(10, custom_counters.stats().compressed_chunks);
+    ASSERT_EQ(2147483647, custom_counters.front());
+    ASSERT_EQ(-2147483647 - 1, custom_counters[1]);
+    for (int custom_index = 0; custom_index < 160; custom_index++) {
+        ASSERT_EQ(custom_index % 2 == 0 ? -custom_index % 5 : custom_index % 3, custom_counters[custom_index + 2]);
+    }
+    custom_counters.clear();
+    ASSERT_TRUE(custom_counters.empty());
+    ASSERT_EQ(0, custom_counters.stats().compressed_chunks);
+}
+
+TEST(CompressedChunkListTest, RecentlyReadStaysPlainTest) {
+    CompressedChunkList<int, 16> custom_list(2, 1);
+    for (int custom_index = 0; custom_index < 32; custom_index++) {
+        custom_list.push_back(custom_index * 3);
+    }
+    for (int custom_index = 32; custom_index < 80; custom_index++) {
+        custom_list.push_back(custom_index * 3);
+        ASSERT_EQ(15, custom_list[5]);
+    }
+    ASSERT_EQ(3, custom_list.stats().compressed_chunks);
+    for (int custom_round = 0; custom_round < 3; custom_round++) {
+        for (int custom_index = 0; custom_index < 16; custom_index++) {
+            ASSERT_EQ(custom_index * 3, custom_list[custom_index]);
+        }
+    }
+    ASSERT_EQ(0, custom_list.stats().chunk_decodes);
+    ASSERT_EQ(60, custom_list[20]);
+    ASSERT_EQ(1, custom_list.stats().chunk_decodes);
+
+    custom_list.set(40, -1);
+    custom_list.set(3, -2);
+    std::vector<int> custom_values;
+    custom_list.for_each([&custom_values](int custom_value) { custom_values.push_back(custom_value); });
+    ASSERT_EQ(80, custom_values.size());
+    ASSERT_EQ(-2, custom_values[3]);
+    ASSERT_EQ(-1, custom_values[40]);
+    ASSERT_EQ(237, custom_values[79]);
+    while (custom_list.size() > 2) {
+        custom_list.pop_back();
+    }
+    ASSERT_EQ(3, custom_list.back());
+    ASSERT_EQ(0, custom_list.stats().compressed_chunks);
+}
+
+TEST(CompressedChunkListTest, CopyTest) {
+    auto custom_source = std::make_unique<CompressedChunkList<int, 8>>(1, 1);
+    for (int custom_index = 0; custom_index < 100; custom_index++) {
+        custom_source->push_back(custom_index);
+        custom_source->at(custom_index / 32);
+    }
+    custom_source->set(50, -50);
+    CompressedChunkList<int, 8> custom_copy(*custom_source);
+    CompressedChunkList<int, 8> custom_assigned;
+    custom_assigned.push_back(7);
+    custom_assigned = *custom_source;
+    custom_source.reset();
+
+    const CompressedChunkList<int, 8> &custom_view = custom_copy;
+    for (int custom_index = 0; custom_index < 100; custom_index++) {
+        int custom_expected = custom_index == 50 ? -50 : custom_index;
+        ASSERT_EQ(custom_expected, custom_view[custom_index]);
+        ASSERT_EQ(custom_expected, custom_assigned[custom_index]);
+    }
+    custom_copy.set(3, 33);
+    ASSERT_EQ(3, custom_assigned[3]);
+    while (!custom_copy.empty()) {
+        custom_copy.pop_back();
+    }
+    ASSERT_EQ(99, custom_assigned.back());
+}
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);